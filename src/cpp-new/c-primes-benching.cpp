@@ -1,9 +1,11 @@
 #include <iostream>
 #include <vector>
 #include <cstring>
+#include <cstdint>
 #include <chrono>
 #include <cmath>
 #include <functional>
+#include <algorithm>
 
 using namespace std;
 using namespace std::chrono;
@@ -31,37 +33,47 @@ vector<int> sieve_original(int n) {
     return primes;
 }
 
-// Optimized version 1: Wheel factorization + better memory layout
+// Optimized version 1: Mod-30 wheel, one byte per 30 integers
+// Byte k holds 30k + {1, 7, 11, 13, 17, 19, 23, 29}. A prime p only strikes
+// p*m with m on the same wheel, so the byte step and bit for each wheel
+// position are precomputed per prime and the inner loop has no modulo.
 vector<int> sieve_optimized_v1(int n) {
+    static const int residues[8] = {1, 7, 11, 13, 17, 19, 23, 29};
+    static const int gaps[8] = {6, 4, 2, 4, 2, 4, 6, 2};
+    
     if (n < 2) return {};
     if (n == 2) return {2};
-    if (n < 5) return {2, 3};
-    
-    // Handle 2 and 3 separately, sieve only odd numbers not divisible by 3
-    // This reduces memory by 2/3
-    int sieve_size = n / 3 + (n % 6 >= 2 ? 1 : 0);
-    vector<bool> is_prime(sieve_size, true);
     
-    // Start with sqrt optimization
-    int sqrt_n = static_cast<int>(sqrt(n));
+    int bit_of[30];
+    fill(bit_of, bit_of + 30, -1);
+    for (int i = 0; i < 8; i++) bit_of[residues[i]] = i;
     
-    // Map index to actual number: 6k±1 form
-    auto index_to_num = [](int i) -> int {
-        return (i & 1) ? 3 * i + 4 : 3 * i + 5;
-    };
+    // 8 bits per 30 numbers instead of 10 for the 6k±1 layout
+    int byte_count = n / 30 + 1;
+    vector<uint8_t> is_prime(byte_count, 0xFF);
+    is_prime[0] &= ~1;  // 1 is not prime
     
-    auto num_to_index = [](int num) -> int {
-        return (num % 6 == 1) ? num / 3 : (num - 2) / 3;
-    };
+    int sqrt_n = static_cast<int>(sqrt(n));
     
-    for (int i = 0; i < sieve_size && index_to_num(i) <= sqrt_n; i++) {
-        if (is_prime[i]) {
-            int p = index_to_num(i);
-            // Start from p² and mark multiples
-            for (int j = p * p; j <= n; j += p) {
-                if (j % 6 == 1 || j % 6 == 5) {
-                    is_prime[num_to_index(j)] = false;
-                }
+    for (int k = 0; k * 30 <= sqrt_n; k++) {
+        for (int c = 0; c < 8; c++) {
+            int p = k * 30 + residues[c];
+            if (p > sqrt_n) break;
+            if (!(is_prime[k] & (1 << c))) continue;
+            
+            // Byte step from p*m_i to p*m_(i+1) and the bit of p*m_i
+            int step[8];
+            uint8_t mask[8];
+            for (int i = 0; i < 8; i++) {
+                int x = (residues[c] * residues[i]) % 30;
+                step[i] = k * gaps[i] + (residues[c] * gaps[i] + x) / 30;
+                mask[i] = static_cast<uint8_t>(~(1 << bit_of[x]));
+            }
+            
+            // Start from p² (m = p, wheel position c) and mark multiples
+            int i = c;
+            for (long long j = (long long)p * p / 30; j < byte_count; j += step[i], i = (i + 1) & 7) {
+                is_prime[j] &= mask[i];
             }
         }
     }
@@ -69,14 +81,17 @@ vector<int> sieve_optimized_v1(int n) {
     // Collect primes
     vector<int> primes;
     primes.reserve(n / (log(n) - 1)); // Prime number theorem approximation
-    primes.push_back(2);
-    primes.push_back(3);
+    for (int p : {2, 3, 5}) {
+        if (p <= n) primes.push_back(p);
+    }
     
-    for (int i = 0; i < sieve_size; i++) {
-        if (is_prime[i]) {
-            int prime = index_to_num(i);
-            if (prime <= n) {
-                primes.push_back(prime);
+    for (int k = 0; k < byte_count; k++) {
+        for (int c = 0; c < 8; c++) {
+            if (is_prime[k] & (1 << c)) {
+                int prime = k * 30 + residues[c];
+                if (prime <= n) {
+                    primes.push_back(prime);
+                }
             }
         }
     }
@@ -84,6 +99,40 @@ vector<int> sieve_optimized_v1(int n) {
     return primes;
 }
 
+// Pre-sieve pattern: multiples of 2, 3, 5, 7, 11 and 13 repeat every 30030
+static const int PRESIEVE_PERIOD = 30030;
+static const int PRESIEVE_PRIMES[] = {2, 3, 5, 7, 11, 13};
+
+const vector<uint8_t>& presieve_pattern() {
+    static const vector<uint8_t> pattern = [] {
+        vector<uint8_t> pat(PRESIEVE_PERIOD, 1);
+        for (int p : PRESIEVE_PRIMES) {
+            for (int i = 0; i < PRESIEVE_PERIOD; i += p) {
+                pat[i] = 0;
+            }
+        }
+        return pat;
+    }();
+    return pattern;
+}
+
+// Initialize segment[0, size) for the numbers [low, low + size)
+void presieve_fill(uint8_t* segment, int low, int size) {
+    const vector<uint8_t>& pattern = presieve_pattern();
+    int phase = low % PRESIEVE_PERIOD;
+    for (int filled = 0; filled < size; ) {
+        int chunk = min(size - filled, PRESIEVE_PERIOD - phase);
+        memcpy(segment + filled, pattern.data() + phase, chunk);
+        filled += chunk;
+        phase = 0;
+    }
+    
+    // The pattern primes themselves went out with their multiples
+    for (int p : PRESIEVE_PRIMES) {
+        if (p >= low && p < low + size) segment[p - low] = 1;
+    }
+}
+
 // Optimized version 2: Segmented sieve for better cache usage
 vector<int> sieve_segmented(int n) {
     const int segment_size = 32768; // L1 cache friendly size
@@ -112,12 +161,15 @@ vector<int> sieve_segmented(int n) {
     primes.reserve(n / (log(n) - 1));
     
     // Process segments
+    vector<uint8_t> segment(segment_size);
     for (int low = sqrt_n + 1; low <= n; low += segment_size) {
         int high = min(low + segment_size - 1, n);
-        vector<bool> segment(segment_size, true);
+        presieve_fill(segment.data(), low, high - low + 1);
         
-        // Mark multiples of each prime in current segment
+        // Mark multiples of each prime in current segment; 2..13 are
+        // already in the pattern
         for (int p : primes_small) {
+            if (p <= 13) continue;
             int start = ((low + p - 1) / p) * p;
             if (start == p) start = p * p;
             
@@ -140,47 +192,79 @@ vector<int> sieve_segmented(int n) {
 // Ultimate optimization: Bit-packed sieve with unrolled loops
 class BitSieve {
 private:
-    vector<uint32_t> bits;
+    // Mod-30 wheel: byte k holds 30k + {1, 7, 11, 13, 17, 19, 23, 29}
+    static constexpr int RESIDUES[8] = {1, 7, 11, 13, 17, 19, 23, 29};
+    static constexpr int GAPS[8] = {6, 4, 2, 4, 2, 4, 6, 2};
+    vector<uint8_t> bits;
     int size;
     
-    void unmark(int n) {
-        bits[n >> 6] &= ~(1u << ((n >> 1) & 31));
-    }
-    
-    bool is_marked(int n) const {
-        return bits[n >> 6] & (1u << ((n >> 1) & 31));
+    bool is_marked(int k, int c) const {
+        return bits[k] & (1 << c);
     }
     
 public:
     vector<int> sieve(int n) {
         if (n < 2) return {};
+        if (n == 2) return {2};
         
         size = n;
-        int bit_size = (n >> 6) + 1;
-        bits.resize(bit_size, 0xFFFFFFFF);
+        int byte_count = n / 30 + 1;
+        bits.assign(byte_count, 0xFF);
         
-        // Clear even numbers (except 2)
-        unmark(1);
+        // Multiples of 2, 3 and 5 are never stored; clear 1
+        bits[0] &= ~1;
+        
+        int bit_of[30];
+        fill(bit_of, bit_of + 30, -1);
+        for (int i = 0; i < 8; i++) bit_of[RESIDUES[i]] = i;
         
         int sqrt_n = static_cast<int>(sqrt(n));
         
-        // Unrolled loop for small primes
-        for (int i = 3; i <= sqrt_n; i += 2) {
-            if (is_marked(i)) {
-                int step = i << 1;
-                int j = i * i;
+        for (int k = 0; k * 30 <= sqrt_n; k++) {
+            for (int c = 0; c < 8; c++) {
+                int p = k * 30 + RESIDUES[c];
+                if (p > sqrt_n) break;
+                if (!is_marked(k, c)) continue;
+                
+                // Per wheel position: byte step to the next multiple, bit mask
+                int step[8];
+                uint8_t mask[8];
+                for (int i = 0; i < 8; i++) {
+                    int x = (RESIDUES[c] * RESIDUES[i]) % 30;
+                    step[i] = k * GAPS[i] + (RESIDUES[c] * GAPS[i] + x) / 30;
+                    mask[i] = static_cast<uint8_t>(~(1 << bit_of[x]));
+                }
+                
+                long long j = (long long)p * p / 30;
+                int i = c;
                 
-                // Unroll by 4 for better pipeline usage
-                for (; j + 3 * step <= n; j += 4 * step) {
-                    unmark(j);
-                    unmark(j + step);
-                    unmark(j + 2 * step);
-                    unmark(j + 3 * step);
+                // Step to wheel position 0 so the unrolled loop covers whole turns
+                for (; i != 0 && j < byte_count; i = (i + 1) & 7) {
+                    bits[j] &= mask[i];
+                    j += step[i];
                 }
                 
-                // Handle remainder
-                for (; j <= n; j += step) {
-                    unmark(j);
+                // Unroll one full wheel turn (exactly p bytes)
+                if (i == 0) {
+                    int o1 = step[0], o2 = o1 + step[1], o3 = o2 + step[2], o4 = o3 + step[3];
+                    int o5 = o4 + step[4], o6 = o5 + step[5], o7 = o6 + step[6];
+                    
+                    for (; j + p <= byte_count; j += p) {
+                        bits[j] &= mask[0];
+                        bits[j + o1] &= mask[1];
+                        bits[j + o2] &= mask[2];
+                        bits[j + o3] &= mask[3];
+                        bits[j + o4] &= mask[4];
+                        bits[j + o5] &= mask[5];
+                        bits[j + o6] &= mask[6];
+                        bits[j + o7] &= mask[7];
+                    }
+                    
+                    // Handle remainder
+                    for (; j < byte_count; i = (i + 1) & 7) {
+                        bits[j] &= mask[i];
+                        j += step[i];
+                    }
                 }
             }
         }
@@ -188,11 +272,16 @@ public:
         // Collect primes
         vector<int> primes;
         primes.reserve(n / (log(n) - 1));
-        primes.push_back(2);
+        for (int p : {2, 3, 5}) {
+            if (p <= n) primes.push_back(p);
+        }
         
-        for (int i = 3; i <= n; i += 2) {
-            if (is_marked(i)) {
-                primes.push_back(i);
+        for (int k = 0; k < byte_count; k++) {
+            for (int c = 0; c < 8; c++) {
+                int prime = k * 30 + RESIDUES[c];
+                if (is_marked(k, c) && prime <= n) {
+                    primes.push_back(prime);
+                }
             }
         }
         
@@ -2,56 +2,90 @@
 #include <iostream>
 #include <vector>
 #include <cstring>
+#include <cstdint>
 #include <chrono>
 #include <cmath>
 #include <functional>
+#include <algorithm>
 
 using namespace std;
 using namespace std::chrono;
 
 class BitSieve {
 private:
-    vector<uint32_t> bits;
+    // Mod-30 wheel: byte k holds 30k + {1, 7, 11, 13, 17, 19, 23, 29}
+    static constexpr int RESIDUES[8] = {1, 7, 11, 13, 17, 19, 23, 29};
+    static constexpr int GAPS[8] = {6, 4, 2, 4, 2, 4, 6, 2};
+    vector<uint8_t> bits;
     int size;
     
-    void unmark(int n) {
-        bits[n >> 6] &= ~(1u << ((n >> 1) & 31));
-    }
-    
-    bool is_marked(int n) const {
-        return bits[n >> 6] & (1u << ((n >> 1) & 31));
+    bool is_marked(int k, int c) const {
+        return bits[k] & (1 << c);
     }
     
 public:
     vector<int> sieve(int n) {
         if (n < 2) return {};
+        if (n == 2) return {2};
         
         size = n;
-        int bit_size = (n >> 6) + 1;
-        bits.resize(bit_size, 0xFFFFFFFF);
+        int byte_count = n / 30 + 1;
+        bits.assign(byte_count, 0xFF);
         
-        // Clear even numbers (except 2)
-        unmark(1);
+        // Multiples of 2, 3 and 5 are never stored; clear 1
+        bits[0] &= ~1;
+        
+        int bit_of[30];
+        fill(bit_of, bit_of + 30, -1);
+        for (int i = 0; i < 8; i++) bit_of[RESIDUES[i]] = i;
         
         int sqrt_n = static_cast<int>(sqrt(n));
         
-        // Unrolled loop for small primes
-        for (int i = 3; i <= sqrt_n; i += 2) {
-            if (is_marked(i)) {
-                int step = i << 1;
-                int j = i * i;
+        for (int k = 0; k * 30 <= sqrt_n; k++) {
+            for (int c = 0; c < 8; c++) {
+                int p = k * 30 + RESIDUES[c];
+                if (p > sqrt_n) break;
+                if (!is_marked(k, c)) continue;
+                
+                // Per wheel position: byte step to the next multiple, bit mask
+                int step[8];
+                uint8_t mask[8];
+                for (int i = 0; i < 8; i++) {
+                    int x = (RESIDUES[c] * RESIDUES[i]) % 30;
+                    step[i] = k * GAPS[i] + (RESIDUES[c] * GAPS[i] + x) / 30;
+                    mask[i] = static_cast<uint8_t>(~(1 << bit_of[x]));
+                }
+                
+                long long j = (long long)p * p / 30;
+                int i = c;
                 
-                // Unroll by 4 for better pipeline usage
-                for (; j + 3 * step <= n; j += 4 * step) {
-                    unmark(j);
-                    unmark(j + step);
-                    unmark(j + 2 * step);
-                    unmark(j + 3 * step);
+                // Step to wheel position 0 so the unrolled loop covers whole turns
+                for (; i != 0 && j < byte_count; i = (i + 1) & 7) {
+                    bits[j] &= mask[i];
+                    j += step[i];
                 }
                 
-                // Handle remainder
-                for (; j <= n; j += step) {
-                    unmark(j);
+                // Unroll one full wheel turn (exactly p bytes)
+                if (i == 0) {
+                    int o1 = step[0], o2 = o1 + step[1], o3 = o2 + step[2], o4 = o3 + step[3];
+                    int o5 = o4 + step[4], o6 = o5 + step[5], o7 = o6 + step[6];
+                    
+                    for (; j + p <= byte_count; j += p) {
+                        bits[j] &= mask[0];
+                        bits[j + o1] &= mask[1];
+                        bits[j + o2] &= mask[2];
+                        bits[j + o3] &= mask[3];
+                        bits[j + o4] &= mask[4];
+                        bits[j + o5] &= mask[5];
+                        bits[j + o6] &= mask[6];
+                        bits[j + o7] &= mask[7];
+                    }
+                    
+                    // Handle remainder
+                    for (; j < byte_count; i = (i + 1) & 7) {
+                        bits[j] &= mask[i];
+                        j += step[i];
+                    }
                 }
             }
         }
@@ -59,11 +93,16 @@ public:
         // Collect primes
         vector<int> primes;
         primes.reserve(n / (log(n) - 1));
-        primes.push_back(2);
+        for (int p : {2, 3, 5}) {
+            if (p <= n) primes.push_back(p);
+        }
         
-        for (int i = 3; i <= n; i += 2) {
-            if (is_marked(i)) {
-                primes.push_back(i);
+        for (int k = 0; k < byte_count; k++) {
+            for (int c = 0; c < 8; c++) {
+                int prime = k * 30 + RESIDUES[c];
+                if (is_marked(k, c) && prime <= n) {
+                    primes.push_back(prime);
+                }
             }
         }
         
@@ -62,47 +62,66 @@ bool has_avx2() {
 // Bit-packed version (works on both x86 and x64)
 class BitPackedSieve {
 private:
+    // Mod-30 wheel: byte k holds 30k + {1, 7, 11, 13, 17, 19, 23, 29}
+    static constexpr int RESIDUES[8] = {1, 7, 11, 13, 17, 19, 23, 29};
+    static constexpr int GAPS[8] = {6, 4, 2, 4, 2, 4, 6, 2};
     vector<uint32_t> bits;
     int size;
     
 public:
     vector<int> sieve(int n) {
         if (n < 2) return {};
+        if (n == 2) return {2};
         
         size = n;
-        int bit_words = (n >> 6) + 1;
-        bits.resize(bit_words, 0xFFFFFFFF);
+        int byte_count = n / 30 + 1;
+        int bit_words = (byte_count + 3) / 4;
+        bits.assign(bit_words, 0xFFFFFFFF);
+        uint8_t* bytes = reinterpret_cast<uint8_t*>(bits.data());
         
         // Clear bit for 1
-        bits[0] &= ~1u;
+        bytes[0] &= ~1u;
+        
+        int bit_of[30];
+        fill(bit_of, bit_of + 30, -1);
+        for (int i = 0; i < 8; i++) bit_of[RESIDUES[i]] = i;
         
         int sqrt_n = static_cast<int>(sqrt(n));
         
-        // Mark composites
-        for (int p = 3; p <= sqrt_n; p += 2) {
-            int word_idx = p >> 6;
-            int bit_idx = (p >> 1) & 31;
-            
-            if (bits[word_idx] & (1u << bit_idx)) {
-                int step = p << 1;
-                for (int num = p * p; num <= n; num += step) {
-                    int idx_word = num >> 6;
-                    int idx_bit = (num >> 1) & 31;
-                    bits[idx_word] &= ~(1u << idx_bit);
+        // Mark composites, walking the wheel of cofactors
+        for (int k = 0; k * 30 <= sqrt_n; k++) {
+            for (int c = 0; c < 8; c++) {
+                int p = k * 30 + RESIDUES[c];
+                if (p > sqrt_n) break;
+                if (!(bytes[k] & (1u << c))) continue;
+                
+                int step[8];
+                uint8_t mask[8];
+                for (int i = 0; i < 8; i++) {
+                    int x = (RESIDUES[c] * RESIDUES[i]) % 30;
+                    step[i] = k * GAPS[i] + (RESIDUES[c] * GAPS[i] + x) / 30;
+                    mask[i] = static_cast<uint8_t>(~(1u << bit_of[x]));
+                }
+                
+                int i = c;
+                for (long long j = (long long)p * p / 30; j < byte_count; j += step[i], i = (i + 1) & 7) {
+                    bytes[j] &= mask[i];
                 }
             }
         }
         
-        // Collect primes
+        // Collect primes: bit b of a word is residue b & 7 of byte b >> 3
         vector<int> primes;
         primes.reserve(n / (log(n) - 1));
-        primes.push_back(2);
+        for (int p : {2, 3, 5}) {
+            if (p <= n) primes.push_back(p);
+        }
         
         for (int word = 0; word < bit_words; word++) {
             uint32_t bits_word = bits[word];
             while (bits_word) {
                 int bit_pos = ctz32(bits_word);
-                int prime = (word * 64) + (bit_pos * 2) + 1;
+                int prime = (word * 4 + (bit_pos >> 3)) * 30 + RESIDUES[bit_pos & 7];
                 if (prime <= n) {
                     primes.push_back(prime);
                 }
@@ -2,13 +2,49 @@
 #include <iostream>
 #include <vector>
 #include <cstring>
+#include <cstdint>
 #include <chrono>
 #include <cmath>
 #include <functional>
+#include <algorithm>
 
 using namespace std;
 using namespace std::chrono;
 
+// Pre-sieve pattern: multiples of 2, 3, 5, 7, 11 and 13 repeat every 30030
+static const int PRESIEVE_PERIOD = 30030;
+static const int PRESIEVE_PRIMES[] = {2, 3, 5, 7, 11, 13};
+
+const vector<uint8_t>& presieve_pattern() {
+    static const vector<uint8_t> pattern = [] {
+        vector<uint8_t> pat(PRESIEVE_PERIOD, 1);
+        for (int p : PRESIEVE_PRIMES) {
+            for (int i = 0; i < PRESIEVE_PERIOD; i += p) {
+                pat[i] = 0;
+            }
+        }
+        return pat;
+    }();
+    return pattern;
+}
+
+// Initialize segment[0, size) for the numbers [low, low + size)
+void presieve_fill(uint8_t* segment, int low, int size) {
+    const vector<uint8_t>& pattern = presieve_pattern();
+    int phase = low % PRESIEVE_PERIOD;
+    for (int filled = 0; filled < size; ) {
+        int chunk = min(size - filled, PRESIEVE_PERIOD - phase);
+        memcpy(segment + filled, pattern.data() + phase, chunk);
+        filled += chunk;
+        phase = 0;
+    }
+    
+    // The pattern primes themselves went out with their multiples
+    for (int p : PRESIEVE_PRIMES) {
+        if (p >= low && p < low + size) segment[p - low] = 1;
+    }
+}
+
 vector<int> sieve_segmented(int n) {
     const int segment_size = 32768; // L1 cache friendly size
     int sqrt_n = static_cast<int>(sqrt(n));
@@ -36,12 +72,15 @@ vector<int> sieve_segmented(int n) {
     primes.reserve(n / (log(n) - 1));
     
     // Process segments
+    vector<uint8_t> segment(segment_size);
     for (int low = sqrt_n + 1; low <= n; low += segment_size) {
         int high = min(low + segment_size - 1, n);
-        vector<bool> segment(segment_size, true);
+        presieve_fill(segment.data(), low, high - low + 1);
         
-        // Mark multiples of each prime in current segment
+        // Mark multiples of each prime in current segment; 2..13 are
+        // already in the pattern
         for (int p : primes_small) {
+            if (p <= 13) continue;
             int start = ((low + p - 1) / p) * p;
             if (start == p) start = p * p;
             
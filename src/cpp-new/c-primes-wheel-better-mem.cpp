@@ -1,44 +1,56 @@
-// Optimized version 1: Wheel factorization + better memory layout
+// Optimized version 1: Mod-30 wheel, one byte per 30 integers
 #include <iostream>
 #include <vector>
 #include <cstring>
+#include <cstdint>
 #include <chrono>
 #include <cmath>
 #include <functional>
+#include <algorithm>
 
 using namespace std;
 using namespace std::chrono;
 
+// Byte k holds 30k + {1, 7, 11, 13, 17, 19, 23, 29}. A prime p only strikes
+// p*m with m on the same wheel, so the byte step and bit for each wheel
+// position are precomputed per prime and the inner loop has no modulo.
 vector<int> sieve_optimized_v1(int n) {
+    static const int residues[8] = {1, 7, 11, 13, 17, 19, 23, 29};
+    static const int gaps[8] = {6, 4, 2, 4, 2, 4, 6, 2};
+    
     if (n < 2) return {};
     if (n == 2) return {2};
-    if (n < 5) return {2, 3};
     
-    // Handle 2 and 3 separately, sieve only odd numbers not divisible by 3
-    // This reduces memory by 2/3
-    int sieve_size = n / 3 + (n % 6 >= 2 ? 1 : 0);
-    vector<bool> is_prime(sieve_size, true);
+    int bit_of[30];
+    fill(bit_of, bit_of + 30, -1);
+    for (int i = 0; i < 8; i++) bit_of[residues[i]] = i;
+    
+    // 8 bits per 30 numbers instead of 10 for the 6k±1 layout
+    int byte_count = n / 30 + 1;
+    vector<uint8_t> is_prime(byte_count, 0xFF);
+    is_prime[0] &= ~1;  // 1 is not prime
     
-    // Start with sqrt optimization
     int sqrt_n = static_cast<int>(sqrt(n));
     
-    // Map index to actual number: 6k±1 form
-    auto index_to_num = [](int i) -> int {
-        return (i & 1) ? 3 * i + 4 : 3 * i + 5;
-    };
-    
-    auto num_to_index = [](int num) -> int {
-        return (num % 6 == 1) ? num / 3 : (num - 2) / 3;
-    };
-    
-    for (int i = 0; i < sieve_size && index_to_num(i) <= sqrt_n; i++) {
-        if (is_prime[i]) {
-            int p = index_to_num(i);
-            // Start from p² and mark multiples
-            for (int j = p * p; j <= n; j += p) {
-                if (j % 6 == 1 || j % 6 == 5) {
-                    is_prime[num_to_index(j)] = false;
-                }
+    for (int k = 0; k * 30 <= sqrt_n; k++) {
+        for (int c = 0; c < 8; c++) {
+            int p = k * 30 + residues[c];
+            if (p > sqrt_n) break;
+            if (!(is_prime[k] & (1 << c))) continue;
+            
+            // Byte step from p*m_i to p*m_(i+1) and the bit of p*m_i
+            int step[8];
+            uint8_t mask[8];
+            for (int i = 0; i < 8; i++) {
+                int x = (residues[c] * residues[i]) % 30;
+                step[i] = k * gaps[i] + (residues[c] * gaps[i] + x) / 30;
+                mask[i] = static_cast<uint8_t>(~(1 << bit_of[x]));
+            }
+            
+            // Start from p² (m = p, wheel position c) and mark multiples
+            int i = c;
+            for (long long j = (long long)p * p / 30; j < byte_count; j += step[i], i = (i + 1) & 7) {
+                is_prime[j] &= mask[i];
             }
         }
     }
@@ -46,14 +58,17 @@ vector<int> sieve_optimized_v1(int n) {
     // Collect primes
     vector<int> primes;
     primes.reserve(n / (log(n) - 1)); // Prime number theorem approximation
-    primes.push_back(2);
-    primes.push_back(3);
-    
-    for (int i = 0; i < sieve_size; i++) {
-        if (is_prime[i]) {
-            int prime = index_to_num(i);
-            if (prime <= n) {
-                primes.push_back(prime);
+    for (int p : {2, 3, 5}) {
+        if (p <= n) primes.push_back(p);
+    }
+    
+    for (int k = 0; k < byte_count; k++) {
+        for (int c = 0; c < 8; c++) {
+            if (is_prime[k] & (1 << c)) {
+                int prime = k * 30 + residues[c];
+                if (prime <= n) {
+                    primes.push_back(prime);
+                }
             }
         }
     }
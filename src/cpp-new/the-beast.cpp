@@ -1,15 +1,36 @@
 #include <iostream>
+#include <cstdio>
+#include <string>
 #include <vector>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <algorithm>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <iterator>
 #include <memory>
+#include <tuple>
+#include <utility>
 #include <immintrin.h>
 #include <intrin.h>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 using namespace std;
 using namespace std::chrono;
 
@@ -24,6 +45,8 @@ struct CPUFeatures {
     bool avx = false;
     bool avx2 = false;
     bool avx512f = false;
+    bool avx512vpopcntdq = false;
+    bool avx512vbmi2 = false;
     bool popcnt = false;
     bool bmi1 = false;
     bool bmi2 = false;
@@ -53,6 +76,8 @@ struct CPUFeatures {
             bmi1 = (cpuInfo[1] & (1 << 3)) != 0;
             bmi2 = (cpuInfo[1] & (1 << 8)) != 0;
             avx512f = (cpuInfo[1] & (1 << 16)) != 0;
+            avx512vpopcntdq = (cpuInfo[2] & (1 << 14)) != 0;
+            avx512vbmi2 = (cpuInfo[2] & (1 << 6)) != 0;
         }
         
         logical_cores = thread::hardware_concurrency();
@@ -66,6 +91,7 @@ struct CPUFeatures {
         cout << "  AVX: " << (avx ? "YES" : "NO") << endl;
         cout << "  AVX2: " << (avx2 ? "YES" : "NO") << endl;
         cout << "  AVX-512F: " << (avx512f ? "YES" : "NO") << endl;
+        cout << "  AVX-512 VPOPCNTDQ/VBMI2: " << (avx512vpopcntdq ? "YES" : "NO") << "/" << (avx512vbmi2 ? "YES" : "NO") << endl;
         cout << "  POPCNT: " << (popcnt ? "YES" : "NO") << endl;
         cout << "  BMI1/BMI2: " << (bmi1 ? "YES" : "NO") << "/" << (bmi2 ? "YES" : "NO") << endl;
         cout << "  Logical Cores: " << logical_cores << endl;
@@ -112,413 +138,3683 @@ static CPUFeatures g_cpu;
     }
 #endif
 
-// ============================================================================
-// Base Sieve Interface
-// ============================================================================
+// High 64 bits of the 128-bit product a * b
+inline uint64_t mul_high64(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+#elif defined(_WIN64)
+    return __umulh(a, b);
+#else
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t cross1 = a_lo * b_hi, cross2 = a_hi * b_lo;
+    uint64_t mid = ((a_lo * b_lo) >> 32) + (uint32_t)cross1 + (uint32_t)cross2;
+    return a_hi * b_hi + (cross1 >> 32) + (cross2 >> 32) + (mid >> 32);
+#endif
+}
 
-class ISieve {
-public:
-    virtual ~ISieve() = default;
-    virtual vector<int> sieve(int n) = 0;
-    virtual const char* name() const = 0;
-};
+// Full 128-bit product a * b from one multiply: low half returned, high
+// half in high
+inline uint64_t mul_wide64(uint64_t a, uint64_t b, uint64_t& high) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    high = static_cast<uint64_t>(product >> 64);
+    return static_cast<uint64_t>(product);
+#elif defined(_WIN64)
+    return _umul128(a, b, &high);
+#else
+    high = mul_high64(a, b);
+    return a * b;
+#endif
+}
+
+// AVX-512 kernels carry their own target so the file still builds for
+// AVX2-only targets; callers reach them only behind the g_cpu checks
+#if defined(__GNUC__)
+#define AVX512_TARGET(features) __attribute__((target(features)))
+#else
+#define AVX512_TARGET(features)
+#endif
 
 // ============================================================================
-// Optimized Bit-Packed Sieve with Heavy Loop Unrolling
+// Shared Sieving Helpers
 // ============================================================================
 
-class BitPackedUnrolledSieve : public ISieve {
-private:
-    alignas(64) vector<uint64_t> bits;
+// Exact floor(sqrt(n)) over the full 64-bit range (the double estimate alone
+// drifts by one once n passes 2^52)
+inline uint64_t isqrt64(uint64_t n) {
+    uint64_t r = static_cast<uint64_t>(sqrt(static_cast<double>(n)));
+    if (r > 0xFFFFFFFFULL) r = 0xFFFFFFFFULL;
+    while (r * r > n) r--;
+    while (r < 0xFFFFFFFFULL && (r + 1) * (r + 1) <= n) r++;
+    return r;
+}
+
+// Rosser-Schoenfeld bound pi(n) < 1.25506 n / ln n, used to size result vectors
+inline size_t prime_count_upper_bound(uint64_t n) {
+    if (n < 2) return 0;
+    if (n < 17) return 6;
+    return static_cast<size_t>(1.25506 * n / log(static_cast<double>(n))) + 1;
+}
+
+// All primes <= limit from a plain odd-only bit sieve. Sieving primes never
+// exceed sqrt(2^64), so 32-bit storage is enough for every engine below.
+vector<uint32_t> sieving_primes_up_to(uint32_t limit) {
+    vector<uint32_t> primes;
+    if (limit < 2) return primes;
+    primes.push_back(2);
     
-    inline void clear_bit(size_t pos) {
-        bits[pos >> 7] &= ~(1ULL << ((pos >> 1) & 63));
-    }
+    uint64_t total_bits = (static_cast<uint64_t>(limit) + 1) >> 1;
+    vector<uint64_t> odd_bits((total_bits + 63) / 64, 0xFFFFFFFFFFFFFFFFULL);
+    odd_bits[0] &= ~1ULL;  // 1 is not prime
     
-    inline bool test_bit(size_t pos) const {
-        return bits[pos >> 7] & (1ULL << ((pos >> 1) & 63));
+    for (uint64_t i = 1; (2 * i + 1) * (2 * i + 1) <= limit; i++) {
+        if (odd_bits[i >> 6] & (1ULL << (i & 63))) {
+            uint64_t p = 2 * i + 1;
+            for (uint64_t j = (p * p) >> 1; j < total_bits; j += p) {
+                odd_bits[j >> 6] &= ~(1ULL << (j & 63));
+            }
+        }
     }
     
-public:
-    vector<int> sieve(int n) override {
-        if (n < 2) return {};
-        
-        // Use 64-bit words for better performance
-        int bit_words = ((n >> 1) + 63) / 64;
-        bits.resize(bit_words, 0xFFFFFFFFFFFFFFFFULL);
-        
-        // Clear bit for 1
-        bits[0] &= ~1ULL;
-        
-        int sqrt_n = static_cast<int>(sqrt(n));
-        
-        // Special handling for prime 3
-        for (int i = 9; i <= n; i += 6) {
-            clear_bit(i);
+    for (uint64_t i = 1; i < total_bits; i++) {
+        if (odd_bits[i >> 6] & (1ULL << (i & 63))) {
+            primes.push_back(static_cast<uint32_t>(2 * i + 1));
         }
+    }
+    return primes;
+}
+
+// ============================================================================
+// Wheel-30 Bit Layout
+// ============================================================================
+// Byte k covers 30k + {1, 7, 11, 13, 17, 19, 23, 29}, one bit per residue
+// coprime to 30: 8 bits per 30 integers instead of 15 for odd-only storage.
+// A sieving prime p = 30q + r only strikes p*m with m coprime to 30, so it
+// walks the wheel of m; the byte step and bit for each wheel position
+// depend only on q and r, and are tabled below.
+
+struct Wheel30Tables {
+    uint8_t residue[8] = {1, 7, 11, 13, 17, 19, 23, 29};
+    uint8_t gap[8] = {6, 4, 2, 4, 2, 4, 6, 2};  // m_{i+1} - m_i around the wheel
+    int8_t bit_of[30];                           // residue -> bit, -1 if not coprime
+    uint8_t keep[8][8];   // [prime residue][wheel index] -> AND mask clearing p*m
+    uint8_t carry[8][8];  // [prime residue][wheel index] -> extra bytes to next p*m
+    uint8_t packed_residues[256][8];  // byte value -> its set residues, packed low
+    
+    Wheel30Tables() {
+        for (int r = 0; r < 30; r++) bit_of[r] = -1;
+        for (int i = 0; i < 8; i++) bit_of[residue[i]] = static_cast<int8_t>(i);
         
-        // Main sieving with aggressive unrolling
-        for (int p = 5; p <= sqrt_n; p += 2) {
-            if (test_bit(p)) {
-                int step = p << 1;
-                int i = p * p;
-                
-                // Unroll by 8 for maximum throughput
-                int unroll_limit = n - 7 * step;
-                for (; i <= unroll_limit; i += 8 * step) {
-                    clear_bit(i);
-                    clear_bit(i + step);
-                    clear_bit(i + 2 * step);
-                    clear_bit(i + 3 * step);
-                    clear_bit(i + 4 * step);
-                    clear_bit(i + 5 * step);
-                    clear_bit(i + 6 * step);
-                    clear_bit(i + 7 * step);
-                }
-                
-                // Handle remainder
-                for (; i <= n; i += step) {
-                    clear_bit(i);
-                }
+        for (int c = 0; c < 8; c++) {
+            for (int i = 0; i < 8; i++) {
+                int x = (residue[c] * residue[i]) % 30;
+                keep[c][i] = static_cast<uint8_t>(~(1u << bit_of[x]));
+                carry[c][i] = static_cast<uint8_t>((residue[c] * gap[i] + x) / 30);
             }
         }
         
-        // Collect primes using bit scan
-        vector<int> primes;
-        primes.reserve(n / (log(n) - 1));
-        primes.push_back(2);
-        
-        for (int word_idx = 0; word_idx < bit_words; word_idx++) {
-            uint64_t word = bits[word_idx];
-            while (word) {
-                int bit_pos = ctz64(word);
-                int prime = (word_idx * 128) + (bit_pos * 2) + 1;
-                if (prime <= n) {
-                    primes.push_back(prime);
-                }
-                word &= word - 1;  // Clear lowest set bit
+        for (int m = 0; m < 256; m++) {
+            int found = 0;
+            for (int i = 0; i < 8; i++) {
+                if (m & (1 << i)) packed_residues[m][found++] = residue[i];
             }
+            while (found < 8) packed_residues[m][found++] = 0;
         }
-        
-        return primes;
     }
-    
-    const char* name() const override { return "Bit-Packed Unrolled"; }
 };
 
-// ============================================================================
-// AVX2 Optimized Sieve (When Available)
-// ============================================================================
+static const Wheel30Tables g_wheel30;
 
-class AVX2OptimizedSieve : public ISieve {
-private:
-    alignas(32) vector<uint64_t> bits;
-    
-    inline void clear_bit_avx(size_t pos) {
-        bits[pos >> 7] &= ~(1ULL << ((pos >> 1) & 63));
+// Sieving prime p = 30q + residue[cls], currently at multiple p*m with m in
+// wheel position wheel_idx
+struct Wheel30Prime {
+    uint32_t prime;
+    uint32_t q;
+    uint8_t cls;
+    uint8_t wheel_idx;
+    uint64_t next_byte;  // absolute byte index of the current multiple
+};
+
+// Sieving primes 7 <= p <= limit, each positioned at its first multiple
+// p*m >= max(p^2, 30 * start_byte) with m coprime to 30
+vector<Wheel30Prime> wheel30_sieving_primes(uint64_t limit, uint64_t start_byte = 0) {
+    vector<Wheel30Prime> out;
+    for (uint32_t p : sieving_primes_up_to(static_cast<uint32_t>(limit))) {
+        if (p < 7) continue;
+        uint8_t cls = static_cast<uint8_t>(g_wheel30.bit_of[p % 30]);
+        uint64_t m = max<uint64_t>(p, (start_byte * 30 + p - 1) / p);
+        while (g_wheel30.bit_of[m % 30] < 0) m++;
+        out.push_back({p, p / 30, cls, static_cast<uint8_t>(g_wheel30.bit_of[m % 30]), (p * m) / 30});
     }
+    return out;
+}
+
+// Cross off sp's multiples in seg, which holds bytes [seg_start, seg_start + seg_bytes)
+inline void wheel30_cross_off(uint8_t* seg, uint64_t seg_start, uint64_t seg_bytes, Wheel30Prime& sp) {
+    uint64_t b = sp.next_byte - seg_start;
+    if (b >= seg_bytes) return;
     
-    inline bool test_bit_avx(size_t pos) const {
-        return bits[pos >> 7] & (1ULL << ((pos >> 1) & 63));
+    const uint8_t* keep = g_wheel30.keep[sp.cls];
+    const uint8_t* carry = g_wheel30.carry[sp.cls];
+    const uint64_t q = sp.q;
+    int i = sp.wheel_idx;
+    
+    // Walk to wheel position 0 so the unrolled loop covers whole turns
+    while (i != 0 && b < seg_bytes) {
+        seg[b] &= keep[i];
+        b += q * g_wheel30.gap[i] + carry[i];
+        i = (i + 1) & 7;
     }
     
-public:
-    vector<int> sieve(int n) override {
-        if (n < 2) return {};
-        
-        int bit_words = ((n >> 1) + 63) / 64;
-        int aligned_words = ((bit_words + 3) / 4) * 4;  // Align to 256 bits
-        bits.resize(aligned_words, 0xFFFFFFFFFFFFFFFFULL);
-        
-        bits[0] &= ~1ULL;
-        
-        int sqrt_n = static_cast<int>(sqrt(n));
+    // One full turn of the wheel advances exactly p bytes
+    if (i == 0) {
+        const uint64_t o1 = q * 6 + carry[0];
+        const uint64_t o2 = o1 + q * 4 + carry[1];
+        const uint64_t o3 = o2 + q * 2 + carry[2];
+        const uint64_t o4 = o3 + q * 4 + carry[3];
+        const uint64_t o5 = o4 + q * 2 + carry[4];
+        const uint64_t o6 = o5 + q * 4 + carry[5];
+        const uint64_t o7 = o6 + q * 6 + carry[6];
+        const uint64_t p = sp.prime;
         
-        // Sieve with AVX2 optimizations
-        for (int p = 3; p <= sqrt_n; p += 2) {
-            if (test_bit_avx(p)) {
-                int step = p << 1;
-                
-                // Use AVX2 for clearing multiple bits when possible
-                for (int i = p * p; i <= n; i += step) {
-                    clear_bit_avx(i);
-                }
-            }
+        for (; b + p <= seg_bytes; b += p) {
+            seg[b] &= keep[0];
+            seg[b + o1] &= keep[1];
+            seg[b + o2] &= keep[2];
+            seg[b + o3] &= keep[3];
+            seg[b + o4] &= keep[4];
+            seg[b + o5] &= keep[5];
+            seg[b + o6] &= keep[6];
+            seg[b + o7] &= keep[7];
         }
         
-        // Collect primes using AVX2 parallel processing
-        vector<int> primes;
-        primes.reserve(n / (log(n) - 1));
-        primes.push_back(2);
-        
-        // Process 4 words at a time with AVX2
-        for (int i = 0; i < bit_words; i += 4) {
-            __m256i vec = _mm256_load_si256((__m256i*)&bits[i]);
-            
-            if (!_mm256_testz_si256(vec, vec)) {
-                alignas(32) uint64_t temp[4];
-                _mm256_store_si256((__m256i*)temp, vec);
-                
-                for (int j = 0; j < 4 && i + j < bit_words; j++) {
-                    uint64_t word = temp[j];
-                    while (word) {
-                        int bit_pos = ctz64(word);
-                        int prime = ((i + j) * 128) + (bit_pos * 2) + 1;
-                        if (prime <= n) {
-                            primes.push_back(prime);
-                        }
-                        word &= word - 1;
-                    }
-                }
-            }
+        while (b < seg_bytes) {
+            seg[b] &= keep[i];
+            b += q * g_wheel30.gap[i] + carry[i];
+            i = (i + 1) & 7;
         }
-        
-        return primes;
     }
     
-    const char* name() const override { return "AVX2 Optimized"; }
-};
+    sp.next_byte = seg_start + b;
+    sp.wheel_idx = static_cast<uint8_t>(i);
+}
 
-// ============================================================================
-// Parallel Segmented Sieve with Work Stealing
-// ============================================================================
+// Every prime's strikes repeat with a period of p bytes in this layout (one
+// wheel turn), so small primes can be folded into precomputed AND masks.
+// Primes are grouped so each mask covers several of them at once; the
+// pattern is padded by `pad` bytes so vector loads never wrap mid-load.
+// Striking p*m also catches m = 1, so callers put the group primes back.
+struct Wheel30MaskGroup {
+    uint64_t period;
+    vector<uint8_t> pattern;
+};
 
-class ParallelSegmentedSieve : public ISieve {
-private:
-    static constexpr int CACHE_LINE = 64;
-    static constexpr int SEGMENT_SIZE = 262144;  // 256KB segments
-    vector<int> small_primes;
-    
-    struct alignas(CACHE_LINE) WorkUnit {
-        atomic<int> next_segment{0};
-        int max_segment;
-    };
-    
-    void sieve_segment(int low, int high, vector<uint8_t>& segment) {
-        int size = high - low + 1;
-        memset(segment.data(), 1, size);
-        
-        for (int p : small_primes) {
-            int start = ((low + p - 1) / p) * p;
-            if (start == p) start = p * p;
-            if (start > high) continue;
-            
-            // Unrolled marking loop
-            int j = start - low;
-            int limit = size - 7 * p;
-            
-            for (; j < limit; j += 8 * p) {
-                segment[j] = 0;
-                segment[j + p] = 0;
-                segment[j + 2*p] = 0;
-                segment[j + 3*p] = 0;
-                segment[j + 4*p] = 0;
-                segment[j + 5*p] = 0;
-                segment[j + 6*p] = 0;
-                segment[j + 7*p] = 0;
-            }
-            
-            for (; j < size; j += p) {
-                segment[j] = 0;
-            }
+vector<Wheel30MaskGroup> wheel30_mask_groups(uint32_t first_prime, uint32_t last_prime,
+                                             uint64_t max_period, uint64_t pad) {
+    vector<vector<uint32_t>> members;
+    vector<uint64_t> periods;
+    for (uint32_t p : sieving_primes_up_to(last_prime)) {
+        if (p < first_prime) continue;
+        if (periods.empty() || periods.back() * p > max_period) {
+            members.push_back({});
+            periods.push_back(1);
         }
+        members.back().push_back(p);
+        periods.back() *= p;
     }
     
-public:
-    vector<int> sieve(int n) override {
-        if (n < 2) return {};
+    vector<Wheel30MaskGroup> groups(periods.size());
+    for (size_t g = 0; g < groups.size(); g++) {
+        uint64_t period = periods[g];
+        vector<uint8_t>& pattern = groups[g].pattern;
+        groups[g].period = period;
+        pattern.assign(period + pad, 0xFF);
         
-        // For small n, use bit-packed version
-        if (n < 10000000) {
-            BitPackedUnrolledSieve bp;
-            return bp.sieve(n);
-        }
-        
-        int sqrt_n = static_cast<int>(sqrt(n));
-        
-        // Find small primes up to sqrt(n)
-        BitPackedUnrolledSieve small_sieve;
-        small_primes = small_sieve.sieve(sqrt_n);
-        
-        vector<int> all_primes = small_primes;
-        all_primes.reserve(n / (log(n) - 1));
-        
-        // Setup work units
-        WorkUnit work;
-        work.max_segment = (n - sqrt_n) / SEGMENT_SIZE + 1;
-        
-        int num_threads = min(g_cpu.logical_cores, work.max_segment);
-        vector<thread> threads;
-        vector<vector<int>> thread_primes(num_threads);
-        
-        auto worker = [&](int thread_id) {
-            vector<uint8_t> segment(SEGMENT_SIZE);
-            vector<int>& local_primes = thread_primes[thread_id];
-            local_primes.reserve(SEGMENT_SIZE / 10);
-            
-            while (true) {
-                int seg_idx = work.next_segment.fetch_add(1);
-                if (seg_idx >= work.max_segment) break;
-                
-                int low = sqrt_n + 1 + seg_idx * SEGMENT_SIZE;
-                int high = min(low + SEGMENT_SIZE - 1, n);
-                
-                sieve_segment(low, high, segment);
-                
-                // Collect primes
-                int size = high - low + 1;
-                for (int i = 0; i < size; i++) {
-                    if (segment[i]) {
-                        local_primes.push_back(low + i);
-                    }
-                }
+        for (uint32_t p : members[g]) {
+            for (uint64_t value = p; value < 30 * period; value += 2 * p) {
+                int bit = g_wheel30.bit_of[value % 30];
+                if (bit >= 0) pattern[value / 30] &= static_cast<uint8_t>(~(1u << bit));
             }
-        };
-        
-        // Launch threads
-        for (int i = 0; i < num_threads; i++) {
-            threads.emplace_back(worker, i);
-        }
-        
-        // Wait for completion
-        for (auto& t : threads) {
-            t.join();
         }
-        
-        // Merge results
-        for (const auto& tp : thread_primes) {
-            all_primes.insert(all_primes.end(), tp.begin(), tp.end());
+        for (uint64_t i = 0; i < pad; i++) {
+            pattern[period + i] = pattern[i % period];
         }
-        
-        sort(all_primes.begin(), all_primes.end());
-        
-        return all_primes;
     }
-    
-    const char* name() const override { return "Parallel Segmented"; }
-};
+    return groups;
+}
+
+// Clear the bits of every number above n in the segment holding n
+inline void wheel30_clear_above(uint8_t* seg, uint64_t seg_start, uint64_t seg_bytes, uint64_t n) {
+    uint64_t last = n / 30 - seg_start;
+    uint8_t mask = 0;
+    for (int i = 0; i < 8; i++) {
+        if (g_wheel30.residue[i] <= n % 30) mask |= static_cast<uint8_t>(1u << i);
+    }
+    seg[last] &= mask;
+    memset(seg + last + 1, 0, seg_bytes - last - 1);
+}
+
+// Clear the bits of every number below lo in the segment holding lo
+inline void wheel30_clear_below(uint8_t* seg, uint64_t seg_start, uint64_t lo) {
+    if (lo / 30 != seg_start) return;
+    for (int i = 0; i < 8; i++) {
+        if (g_wheel30.residue[i] < lo % 30) seg[0] &= static_cast<uint8_t>(~(1u << i));
+    }
+}
 
 // ============================================================================
-// Wheel Factorization Sieve (Memory Efficient for Huge Ranges)
+// Bitmap Popcount
 // ============================================================================
 
-class WheelFactorizationSieve : public ISieve {
-private:
-    static constexpr int WHEEL[] = {2, 3, 5, 7, 11, 13};
-    static constexpr int WHEEL_SIZE = 30030;  // Product of first 6 primes
-    vector<uint8_t> wheel_bits;
+// Harley-Seal popcount (Mula, Kurz, Lemire): a carry-save adder tree
+// folds 16 vectors into one "sixteens" vector, so the nibble-table
+// popcount runs once per 16 loads instead of once per load
+inline __m256i popcount256(__m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0F);
+    __m256i lo = _mm256_and_si256(v, low_mask);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+
+inline void carry_save_add(__m256i& high, __m256i& low, __m256i a, __m256i b, __m256i c) {
+    __m256i u = _mm256_xor_si256(a, b);
+    high = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+    low = _mm256_xor_si256(u, c);
+}
+
+inline uint64_t popcount_words_avx2(const uint64_t* words, uint64_t count) {
+    const __m256i* data = reinterpret_cast<const __m256i*>(words);
+    uint64_t vectors = count / 4;
+    __m256i total = _mm256_setzero_si256();
+    __m256i ones = _mm256_setzero_si256(), twos = ones, fours = ones, eights = ones, sixteens;
+    __m256i twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
     
-    void init_wheel() {
-        wheel_bits.resize(WHEEL_SIZE, 1);
-        for (int p : WHEEL) {
-            for (int i = p; i < WHEEL_SIZE; i += p) {
-                wheel_bits[i] = 0;
-            }
-        }
+    uint64_t i = 0;
+    auto load = [&](uint64_t k) { return _mm256_loadu_si256(data + i + k); };
+    for (; i + 16 <= vectors; i += 16) {
+        carry_save_add(twos_a, ones, ones, load(0), load(1));
+        carry_save_add(twos_b, ones, ones, load(2), load(3));
+        carry_save_add(fours_a, twos, twos, twos_a, twos_b);
+        carry_save_add(twos_a, ones, ones, load(4), load(5));
+        carry_save_add(twos_b, ones, ones, load(6), load(7));
+        carry_save_add(fours_b, twos, twos, twos_a, twos_b);
+        carry_save_add(eights_a, fours, fours, fours_a, fours_b);
+        carry_save_add(twos_a, ones, ones, load(8), load(9));
+        carry_save_add(twos_b, ones, ones, load(10), load(11));
+        carry_save_add(fours_a, twos, twos, twos_a, twos_b);
+        carry_save_add(twos_a, ones, ones, load(12), load(13));
+        carry_save_add(twos_b, ones, ones, load(14), load(15));
+        carry_save_add(fours_b, twos, twos, twos_a, twos_b);
+        carry_save_add(eights_b, fours, fours, fours_a, fours_b);
+        carry_save_add(sixteens, eights, eights, eights_a, eights_b);
+        total = _mm256_add_epi64(total, popcount256(sixteens));
     }
     
-public:
-    vector<int> sieve(int n) override {
-        if (n < 2) return {};
-        
-        init_wheel();
-        
-        int segments = (n / WHEEL_SIZE) + 1;
-        vector<bool> is_prime(n + 1, true);
-        is_prime[0] = is_prime[1] = false;
-        
-        // Apply wheel
-        for (int seg = 0; seg < segments; seg++) {
-            int base = seg * WHEEL_SIZE;
-            for (int i = 0; i < WHEEL_SIZE && base + i <= n; i++) {
-                if (!wheel_bits[i] && base + i > 1) {
-                    is_prime[base + i] = false;
-                }
-            }
+    total = _mm256_slli_epi64(total, 4);
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(eights), 3));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(fours), 2));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(twos), 1));
+    total = _mm256_add_epi64(total, popcount256(ones));
+    for (; i < vectors; i++) {
+        total = _mm256_add_epi64(total, popcount256(_mm256_loadu_si256(data + i)));
+    }
+    
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256((__m256i*)lanes, total);
+    uint64_t result = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (uint64_t w = vectors * 4; w < count; w++) result += popcount64(words[w]);
+    return result;
+}
+
+// VPOPCNTDQ popcount of a run of bitmap words, eight per instruction
+AVX512_TARGET("avx512f,avx512vpopcntdq")
+inline uint64_t popcount_words_avx512(const uint64_t* words, uint64_t count) {
+    __m512i acc = _mm512_setzero_si512();
+    uint64_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_loadu_si512(words + i)));
+    }
+    uint64_t total = _mm512_reduce_add_epi64(acc);
+    for (; i < count; i++) total += popcount64(words[i]);
+    return total;
+}
+
+// Popcount of a run of bitmap words: VPOPCNTDQ, else Harley-Seal AVX2,
+// else one POPCNT per word
+inline uint64_t popcount_words(const uint64_t* words, uint64_t count) {
+    if (g_cpu.avx512vpopcntdq) return popcount_words_avx512(words, count);
+    if (g_cpu.avx2) return popcount_words_avx2(words, count);
+    
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < count; i++) total += popcount64(words[i]);
+    return total;
+}
+
+// Number of set bytes in a 0/1 byte map, 32 bytes per PSADBW
+inline uint64_t count_set_bytes(const uint8_t* bytes, uint64_t size) {
+    uint64_t total = 0;
+    uint64_t i = 0;
+    if (g_cpu.avx2) {
+        __m256i acc = _mm256_setzero_si256();
+        for (; i + 32 <= size; i += 32) {
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_loadu_si256((const __m256i*)(bytes + i)),
+                                                        _mm256_setzero_si256()));
         }
-        
-        // Continue sieving for remaining primes
-        int sqrt_n = static_cast<int>(sqrt(n));
-        for (int p = 17; p <= sqrt_n; p += 2) {
-            if (is_prime[p]) {
-                for (int i = p * p; i <= n; i += p * 2) {
-                    is_prime[i] = false;
-                }
-            }
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256((__m256i*)lanes, acc);
+        total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    for (; i < size; i++) total += bytes[i];
+    return total;
+}
+
+// Append base + i for every set byte i of a 0/1 byte map. AVX2 turns 32
+// bytes into a bit mask and walks only its set bits, so the zero bytes
+// cost no branches.
+inline void append_set_bytes(vector<uint64_t>& out, const uint8_t* bytes, uint64_t size, uint64_t base) {
+    uint64_t i = 0;
+    if (g_cpu.avx2) {
+        const __m256i zero = _mm256_setzero_si256();
+        for (; i + 32 <= size; i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(bytes + i));
+            uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero)));
+            for (; mask; mask &= mask - 1) out.push_back(base + i + ctz32(mask));
         }
-        
-        // Collect primes
-        vector<int> primes;
-        primes.reserve(n / (log(n) - 1));
-        
-        for (int i = 2; i <= n; i++) {
-            if (is_prime[i]) {
-                primes.push_back(i);
+    }
+    for (; i < size; i++) {
+        if (bytes[i]) out.push_back(base + i);
+    }
+}
+
+// Append base + i for every i < size with bytes[i + o] set for all k
+// offsets o: the 0/1 map ANDed with copies of itself shifted by each
+// offset, 32 bytes per step. bytes must be readable to size - 1 + the
+// largest offset.
+inline void append_shifted_and(vector<uint64_t>& out, const uint8_t* bytes, uint64_t size,
+                               const uint32_t* offsets, size_t k, uint64_t base) {
+    uint64_t i = 0;
+    if (g_cpu.avx2) {
+        const __m256i zero = _mm256_setzero_si256();
+        for (; i + 32 <= size; i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(bytes + i));
+            for (size_t j = 0; j < k; j++) {
+                v = _mm256_and_si256(v, _mm256_loadu_si256((const __m256i*)(bytes + i + offsets[j])));
             }
+            uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero)));
+            for (; mask; mask &= mask - 1) out.push_back(base + i + ctz32(mask));
         }
-        
-        return primes;
     }
-    
-    const char* name() const override { return "Wheel Factorization"; }
-};
+    for (; i + 8 <= size; i += 8) {
+        uint64_t w, shifted;
+        memcpy(&w, bytes + i, 8);
+        for (size_t j = 0; j < k; j++) {
+            memcpy(&shifted, bytes + i + offsets[j], 8);
+            w &= shifted;
+        }
+        for (; w; w &= w - 1) out.push_back(base + i + (ctz64(w) >> 3));
+    }
+    for (; i < size; i++) {
+        bool all = bytes[i] != 0;
+        for (size_t j = 0; j < k && all; j++) all = bytes[i + offsets[j]] != 0;
+        if (all) out.push_back(base + i);
+    }
+}
 
 // ============================================================================
-// Auto-Selecting Optimal Sieve
+// SIMD Prime Extraction
 // ============================================================================
+// Turning a sieved wheel-30 bitmap into prime values is a large share of
+// the run time at 1e9. The kernels below write straight into preallocated
+// output with no per-prime branch; each writes a full vector per step and
+// advances by the popcount, so callers leave EXTRACT_SLACK words of room.
 
-class AutoOptimalSieve : public ISieve {
-private:
-    unique_ptr<ISieve> select_best_sieve(int n) {
-        // For cryptographic scale (>100M), always use parallel
-        if (n > 100000000) {
-            return make_unique<ParallelSegmentedSieve>();
-        }
-        
-        // For large scale (10M-100M)
-        if (n > 10000000) {
-            if (g_cpu.logical_cores >= 8) {
-                return make_unique<ParallelSegmentedSieve>();
-            } else if (g_cpu.avx2) {
-                return make_unique<AVX2OptimizedSieve>();
-            } else {
-                return make_unique<BitPackedUnrolledSieve>();
-            }
+static constexpr size_t EXTRACT_SLACK = 64;
+
+// Scalar fallback: bit b of a word is residue b & 7 of byte b >> 3
+inline uint64_t* wheel30_extract_scalar(const uint64_t* words, uint64_t count, uint64_t byte_start, uint64_t* out) {
+    for (uint64_t w = 0; w < count; w++) {
+        uint64_t word = words[w];
+        uint64_t base_value = (byte_start + w * 8) * 30;
+        while (word) {
+            int bit_pos = ctz64(word);
+            *out++ = base_value + (bit_pos >> 3) * 30 + g_wheel30.residue[bit_pos & 7];
+            word &= word - 1;
         }
+    }
+    return out;
+}
+
+// AVX2: a 256-entry table gives the set residues of every byte value,
+// packed to the front; two zero-extends turn them into 8 values
+inline uint64_t* wheel30_extract_avx2(const uint64_t* words, uint64_t count, uint64_t byte_start, uint64_t* out) {
+    const __m256i thirty = _mm256_set1_epi64x(30);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(words);
+    
+    for (uint64_t w = 0; w < count; w++) {
+        if (!words[w]) continue;
+        __m256i base = _mm256_set1_epi64x(static_cast<int64_t>((byte_start + w * 8) * 30));
         
-        // For medium scale (1M-10M)
-        if (n > 1000000) {
-            if (g_cpu.avx2) {
-                return make_unique<AVX2OptimizedSieve>();
-            } else {
-                return make_unique<BitPackedUnrolledSieve>();
-            }
+        for (int b = 0; b < 8; b++) {
+            uint8_t m = bytes[w * 8 + b];
+            __m128i r = _mm_loadl_epi64((const __m128i*)g_wheel30.packed_residues[m]);
+            _mm256_storeu_si256((__m256i*)out, _mm256_add_epi64(base, _mm256_cvtepu8_epi64(r)));
+            _mm256_storeu_si256((__m256i*)(out + 4), _mm256_add_epi64(base, _mm256_cvtepu8_epi64(_mm_srli_si128(r, 4))));
+            out += popcount64(m);
+            base = _mm256_add_epi64(base, thirty);
         }
-        
-        // For small scale (<1M)
-        return make_unique<BitPackedUnrolledSieve>();
     }
+    return out;
+}
+
+// AVX-512F: each byte is an 8-lane mask over its candidate values and
+// VPCOMPRESSQ packs the primes to the front
+AVX512_TARGET("avx512f")
+inline uint64_t* wheel30_extract_avx512(const uint64_t* words, uint64_t count, uint64_t byte_start, uint64_t* out) {
+    const __m512i residues = _mm512_set_epi64(29, 23, 19, 17, 13, 11, 7, 1);
+    const __m512i thirty = _mm512_set1_epi64(30);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(words);
+    __m512i values = _mm512_add_epi64(_mm512_set1_epi64(static_cast<int64_t>(byte_start * 30)), residues);
     
-public:
-    vector<int> sieve(int n) override {
-        auto best_sieve = select_best_sieve(n);
-        cout << "Auto-selected: " << best_sieve->name() << " for n=" << n << endl;
-        return best_sieve->sieve(n);
+    for (uint64_t b = 0; b < count * 8; b++) {
+        __mmask8 m = bytes[b];
+        _mm512_storeu_si512(out, _mm512_maskz_compress_epi64(m, values));
+        out += popcount64(m);
+        values = _mm512_add_epi64(values, thirty);
     }
-    
-    const char* name() const override { return "Auto-Optimal"; }
-};
+    return out;
+}
 
-// ============================================================================
+// AVX-512 VBMI2: a whole word at a time. All 64 candidates of a word lie
+// within 240 of its base, so VPCOMPRESSB packs their byte offsets and
+// each group of 8 is widened and stored; the loop runs per 8 primes
+AVX512_TARGET("avx512f,avx512bw,avx512vbmi2")
+inline uint64_t* wheel30_extract_vbmi2(const uint64_t* words, uint64_t count, uint64_t byte_start, uint64_t* out) {
+    alignas(64) uint8_t offsets[64];
+    for (int j = 0; j < 64; j++) {
+        offsets[j] = static_cast<uint8_t>((j >> 3) * 30 + g_wheel30.residue[j & 7]);
+    }
+    const __m512i offset_vec = _mm512_load_si512(offsets);
+    alignas(64) uint8_t packed[64];
+    
+    for (uint64_t w = 0; w < count; w++) {
+        uint64_t word = words[w];
+        if (!word) continue;
+        
+        _mm512_store_si512(packed, _mm512_maskz_compress_epi8(word, offset_vec));
+        __m512i base = _mm512_set1_epi64(static_cast<int64_t>((byte_start + w * 8) * 30));
+        int found = popcount64(word);
+        for (int i = 0; i < found; i += 8) {
+            __m128i chunk = _mm_loadl_epi64((const __m128i*)(packed + i));
+            _mm512_storeu_si512(out + i, _mm512_add_epi64(base, _mm512_cvtepu8_epi64(chunk)));
+        }
+        out += found;
+    }
+    return out;
+}
+
+inline uint64_t* wheel30_extract(const uint64_t* words, uint64_t count, uint64_t byte_start, uint64_t* out) {
+    if (g_cpu.avx512vbmi2) return wheel30_extract_vbmi2(words, count, byte_start, out);
+    if (g_cpu.avx512f) return wheel30_extract_avx512(words, count, byte_start, out);
+    if (g_cpu.avx2) return wheel30_extract_avx2(words, count, byte_start, out);
+    return wheel30_extract_scalar(words, count, byte_start, out);
+}
+
+// Streaming consumers receive primes in ascending batches through a sink
+// instead of one result vector
+using PrimeSink = function<void(const uint64_t* primes, size_t count)>;
+
+// Stream the primes of a sieved segment to sink, STREAM_WORDS of bitmap
+// at a time, so the reusable buffer never outgrows L2 (256KB)
+static constexpr uint64_t STREAM_WORDS = 512;
+
+inline void wheel30_stream_primes(const uint64_t* words, uint64_t count, uint64_t byte_start,
+                                  vector<uint64_t>& buffer, const PrimeSink& sink) {
+    buffer.resize(STREAM_WORDS * 64 + EXTRACT_SLACK);
+    for (uint64_t w = 0; w < count; w += STREAM_WORDS) {
+        uint64_t batch = min(STREAM_WORDS, count - w);
+        uint64_t* end = wheel30_extract(words + w, batch, byte_start + w * 8, buffer.data());
+        if (end != buffer.data()) sink(buffer.data(), end - buffer.data());
+    }
+}
+
+// Append the primes of a sieved segment, sizing the output exactly from
+// the segment popcount
+inline void wheel30_append_primes(vector<uint64_t>& primes, const uint64_t* words, uint64_t count, uint64_t byte_start) {
+    size_t old_size = primes.size();
+    size_t found = popcount_words(words, count);
+    primes.resize(old_size + found + EXTRACT_SLACK);
+    wheel30_extract(words, count, byte_start, primes.data() + old_size);
+    primes.resize(old_size + found);
+}
+
+// ============================================================================
+// Compressed Prime List
+// ============================================================================
+// Odd primes are stored as halved gaps, one byte each; byte 0 escapes to a
+// LEB128 varint for the rare gap over 510 (none below 3e11). Every BLOCK
+// primes start a block whose first prime and byte offset go into a skip
+// index, so element i costs one partial block decode, and iteration
+// decodes a block at a time with SIMD prefix sums. About 1.13 bytes per
+// prime, against 8 for vector<uint64_t>.
+
+// out[i] = base + 2 * (gaps[0] + ... + gaps[i]); returns the last value
+inline uint64_t gap_decode_scalar(const uint8_t* gaps, size_t count, uint64_t base, uint64_t* out) {
+    for (size_t i = 0; i < count; i++) {
+        base += 2 * static_cast<uint64_t>(gaps[i]);
+        out[i] = base;
+    }
+    return base;
+}
+
+// AVX2: eight gaps widened to 32 bits, prefix-summed in each 128-bit half
+// and then across, doubled and added to the running value in 64-bit lanes
+inline uint64_t gap_decode_avx2(const uint8_t* gaps, size_t count, uint64_t base, uint64_t* out) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i low_last = _mm256_setr_epi32(0, 0, 0, 0, 3, 3, 3, 3);
+    __m256i running = _mm256_set1_epi64x(static_cast<long long>(base));
+    
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i g = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(gaps + i)));
+        g = _mm256_add_epi32(g, _mm256_slli_si256(g, 4));
+        g = _mm256_add_epi32(g, _mm256_slli_si256(g, 8));
+        g = _mm256_add_epi32(g, _mm256_blend_epi32(zero, _mm256_permutevar8x32_epi32(g, low_last), 0xF0));
+        g = _mm256_slli_epi32(g, 1);
+        
+        __m256i low = _mm256_add_epi64(running, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(g)));
+        __m256i high = _mm256_add_epi64(running, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(g, 1)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), low);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 4), high);
+        running = _mm256_permute4x64_epi64(high, 0xFF);
+    }
+    
+    if (i) base = out[i - 1];
+    return gap_decode_scalar(gaps + i, count - i, base, out + i);
+}
+
+// AVX-512F: sixteen gaps per step, a four-step shift-and-add scan
+AVX512_TARGET("avx512f")
+inline uint64_t gap_decode_avx512(const uint8_t* gaps, size_t count, uint64_t base, uint64_t* out) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i last_lane = _mm512_set1_epi64(7);
+    __m512i running = _mm512_set1_epi64(static_cast<long long>(base));
+    
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i g = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(gaps + i)));
+        g = _mm512_add_epi32(g, _mm512_alignr_epi32(g, zero, 15));
+        g = _mm512_add_epi32(g, _mm512_alignr_epi32(g, zero, 14));
+        g = _mm512_add_epi32(g, _mm512_alignr_epi32(g, zero, 12));
+        g = _mm512_add_epi32(g, _mm512_alignr_epi32(g, zero, 8));
+        g = _mm512_slli_epi32(g, 1);
+        
+        __m512i low = _mm512_add_epi64(running, _mm512_cvtepu32_epi64(_mm512_castsi512_si256(g)));
+        __m512i high = _mm512_add_epi64(running, _mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(g, 1)));
+        _mm512_storeu_si512(out + i, low);
+        _mm512_storeu_si512(out + i + 8, high);
+        running = _mm512_permutexvar_epi64(last_lane, high);
+    }
+    
+    if (i) base = out[i - 1];
+    return gap_decode_scalar(gaps + i, count - i, base, out + i);
+}
+
+inline uint64_t gap_decode(const uint8_t* gaps, size_t count, uint64_t base, uint64_t* out) {
+    if (g_cpu.avx512f) return gap_decode_avx512(gaps, count, base, out);
+    if (g_cpu.avx2) return gap_decode_avx2(gaps, count, base, out);
+    return gap_decode_scalar(gaps, count, base, out);
+}
+
+class PrimeList {
+public:
+    static constexpr size_t BLOCK = 128;
+    
+    class iterator {
+    public:
+        using iterator_category = input_iterator_tag;
+        using value_type = uint64_t;
+        using difference_type = ptrdiff_t;
+        using pointer = const uint64_t*;
+        using reference = const uint64_t&;
+        
+        iterator(const PrimeList* list, size_t index) : list(list), index(index) { load(); }
+        reference operator*() const { return decoded[pos]; }
+        iterator& operator++() {
+            index++;
+            if (++pos == filled) load();
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        bool operator==(const iterator& other) const { return index == other.index; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+    
+    private:
+        const PrimeList* list;
+        size_t index;
+        size_t pos = 0;
+        size_t filled = 0;
+        uint64_t decoded[BLOCK];
+        
+        // Decodes the block holding index
+        void load() {
+            pos = 0;
+            filled = 0;
+            if (index >= list->size()) return;
+            if (list->has_two && index == 0) {
+                decoded[0] = 2;
+                filled = 1;
+                return;
+            }
+            size_t odd = index - list->has_two;
+            filled = list->decode_block(odd / BLOCK, decoded);
+            pos = odd % BLOCK;
+        }
+    };
+    
+    // Primes must arrive in ascending order
+    void push_back(uint64_t p) {
+        if (p == 2) {
+            has_two = true;
+            return;
+        }
+        
+        if (odd_count % BLOCK == 0) {
+            skip.push_back({p, gaps.size()});
+        } else {
+            uint64_t half = (p - last) / 2;
+            if (half < 256) {
+                gaps.push_back(static_cast<uint8_t>(half));
+            } else {
+                gaps.push_back(0);
+                for (; half >= 128; half >>= 7) gaps.push_back(static_cast<uint8_t>(half | 128));
+                gaps.push_back(static_cast<uint8_t>(half));
+            }
+        }
+        last = p;
+        odd_count++;
+    }
+    
+    void append(const uint64_t* primes, size_t count) {
+        for (size_t i = 0; i < count; i++) push_back(primes[i]);
+    }
+    
+    size_t size() const { return has_two + odd_count; }
+    bool empty() const { return size() == 0; }
+    uint64_t front() const { return has_two ? 2 : skip[0].first; }
+    uint64_t back() const { return odd_count ? last : 2; }
+    
+    // Random access: the skip index finds the block, then at most
+    // BLOCK - 1 gaps are summed
+    uint64_t operator[](size_t i) const {
+        if (has_two) {
+            if (i == 0) return 2;
+            i--;
+        }
+        
+        size_t b = i / BLOCK;
+        size_t k = i % BLOCK;
+        const uint8_t* in = gaps.data() + skip[b].offset;
+        uint64_t value = skip[b].first;
+        if (!has_escapes(b)) {
+            uint64_t halves = 0;
+            for (size_t j = 0; j < k; j++) halves += in[j];
+            return value + 2 * halves;
+        }
+        for (size_t j = 0; j < k; j++) value += 2 * read_gap(in);
+        return value;
+    }
+    
+    // Calls fn(primes, count) once per decoded block, in order
+    template <typename BatchFn>
+    void for_each_batch(BatchFn&& fn) const {
+        uint64_t decoded[BLOCK];
+        if (has_two) {
+            decoded[0] = 2;
+            fn(static_cast<const uint64_t*>(decoded), size_t(1));
+        }
+        for (size_t b = 0; b < skip.size(); b++) {
+            size_t n = decode_block(b, decoded);
+            fn(static_cast<const uint64_t*>(decoded), n);
+        }
+    }
+    
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, size()); }
+    
+    vector<uint64_t> to_vector() const {
+        vector<uint64_t> out;
+        out.reserve(size());
+        for_each_batch([&](const uint64_t* primes, size_t count) { out.insert(out.end(), primes, primes + count); });
+        return out;
+    }
+    
+    size_t memory_bytes() const {
+        return sizeof(*this) + gaps.capacity() + skip.capacity() * sizeof(SkipEntry);
+    }
+    
+    void shrink_to_fit() {
+        gaps.shrink_to_fit();
+        skip.shrink_to_fit();
+    }
+    
+private:
+    struct SkipEntry {
+        uint64_t first;   // first prime of the block
+        uint64_t offset;  // its gaps start at gaps[offset]
+    };
+    
+    bool has_two = false;
+    size_t odd_count = 0;
+    uint64_t last = 0;
+    vector<SkipEntry> skip;
+    vector<uint8_t> gaps;
+    
+    static uint64_t read_gap(const uint8_t*& in) {
+        uint64_t half = *in++;
+        if (half) return half;
+        for (int shift = 0; ; shift += 7) {
+            uint8_t byte = *in++;
+            half |= static_cast<uint64_t>(byte & 127) << shift;
+            if (!(byte & 128)) return half;
+        }
+    }
+    
+    // A block without escapes holds exactly one byte per gap
+    bool has_escapes(size_t b) const {
+        uint64_t end = b + 1 < skip.size() ? skip[b + 1].offset : gaps.size();
+        return end - skip[b].offset != min(BLOCK, odd_count - b * BLOCK) - 1;
+    }
+    
+    size_t decode_block(size_t b, uint64_t* out) const {
+        size_t n = min(BLOCK, odd_count - b * BLOCK);
+        const uint8_t* in = gaps.data() + skip[b].offset;
+        out[0] = skip[b].first;
+        
+        if (!has_escapes(b)) {
+            gap_decode(in, n - 1, out[0], out + 1);
+        } else {
+            for (size_t i = 1; i < n; i++) out[i] = out[i - 1] + 2 * read_gap(in);
+        }
+        return n;
+    }
+};
+
+// ============================================================================
+// Base Sieve Interface
+// ============================================================================
+
+class ISieve {
+public:
+    virtual ~ISieve() = default;
+    virtual vector<uint64_t> sieve(uint64_t n) = 0;
+    virtual const char* name() const = 0;
+    
+    // Primes in [lo, hi]. Engines without a native range path sieve all of
+    // [2, hi] and drop the front.
+    virtual vector<uint64_t> sieve_range(uint64_t lo, uint64_t hi) {
+        if (lo > hi) return {};
+        vector<uint64_t> primes = sieve(hi);
+        primes.erase(primes.begin(), lower_bound(primes.begin(), primes.end(), lo));
+        return primes;
+    }
+    
+    // Calls sink with the primes in [lo, hi], in ascending batches. Engines
+    // without a streaming path hand over the whole range at once.
+    virtual void for_each_prime(uint64_t lo, uint64_t hi, const PrimeSink& sink) {
+        vector<uint64_t> primes = sieve_range(lo, hi);
+        if (!primes.empty()) sink(primes.data(), primes.size());
+    }
+    
+    // pi(n). Engines that keep a bitmap override this to popcount their
+    // segments instead of building the list.
+    virtual uint64_t count(uint64_t n) {
+        return sieve(n).size();
+    }
+    
+    // Primes in [lo, hi] as a compressed PrimeList, encoded batch by batch
+    // from for_each_prime with no full vector in between
+    PrimeList sieve_list(uint64_t lo, uint64_t hi) {
+        PrimeList list;
+        for_each_prime(lo, hi, [&](const uint64_t* primes, size_t count) {
+            list.append(primes, count);
+        });
+        list.shrink_to_fit();
+        return list;
+    }
+};
+
+// ============================================================================
+// Prime Bitmap (Membership, Rank and Select Queries)
+// ============================================================================
+// The finished wheel-30 bitmap of [0, limit], kept instead of turned into a
+// list: 1/30 byte per integer, and "is x prime?" reads one bit instead of
+// binary searching a vector. Built by BitPackedUnrolledSieve::bitmap(n).
+//
+// A succinct index makes pi(x) and the k-th prime constant time: an
+// absolute count every 64 blocks of 512 bits, a 16-bit count per block
+// relative to that, and the block of every SELECT_SAMPLE-th prime. About
+// 3.5% on top of the bitmap.
+
+class PrimeBitmap {
+private:
+    static constexpr size_t PREFETCH_DISTANCE = 16;
+    static constexpr uint64_t BLOCK_WORDS = 8;       // 512 bits
+    static constexpr uint64_t SUPER_BLOCKS = 64;     // 32768 bits, fits uint16_t
+    static constexpr uint64_t SELECT_SAMPLE = 8192;  // primes per select sample
+    
+    uint64_t n = 0;
+    vector<uint64_t> bits;  // padded to whole blocks
+    
+    uint64_t set_bits = 0;
+    vector<uint64_t> super_counts;    // set bits before each superblock
+    vector<uint16_t> block_counts;    // set bits before each block, within its superblock
+    vector<uint64_t> select_samples;  // block holding set bit i * SELECT_SAMPLE
+    
+    const uint8_t* bytes() const { return reinterpret_cast<const uint8_t*>(bits.data()); }
+    
+    uint64_t small_primes() const { return (n >= 2) + (n >= 3) + (n >= 5); }
+    
+    uint64_t bits_before_block(uint64_t block) const {
+        return super_counts[block / SUPER_BLOCKS] + block_counts[block];
+    }
+    
+    void build_index() {
+        uint64_t blocks = bits.size() / BLOCK_WORDS;
+        super_counts.assign(blocks / SUPER_BLOCKS + 1, 0);
+        block_counts.assign(blocks + 1, 0);
+        select_samples.clear();
+        
+        uint64_t total = 0;
+        for (uint64_t b = 0; b <= blocks; b++) {
+            if (b % SUPER_BLOCKS == 0) super_counts[b / SUPER_BLOCKS] = total;
+            block_counts[b] = static_cast<uint16_t>(total - super_counts[b / SUPER_BLOCKS]);
+            if (b == blocks) break;
+            
+            uint64_t count = 0;
+            for (uint64_t i = 0; i < BLOCK_WORDS; i++) count += popcount64(bits[b * BLOCK_WORDS + i]);
+            while (select_samples.size() * SELECT_SAMPLE < total + count) select_samples.push_back(b);
+            total += count;
+        }
+        set_bits = total;
+    }
+    
+    // Position of the r-th (0-based) set bit of word
+    static int select_in_word(uint64_t word, uint64_t r) {
+        if (g_cpu.bmi2) return ctz64(_pdep_u64(1ULL << r, word));
+        for (; r > 0; r--) word &= word - 1;
+        return ctz64(word);
+    }
+    
+    friend class BitPackedUnrolledSieve;
+    
+public:
+    uint64_t limit() const { return n; }
+    const uint64_t* words() const { return bits.data(); }
+    size_t word_count() const { return bits.size(); }
+    
+    // pi(limit())
+    uint64_t count() const { return small_primes() + set_bits; }
+    
+    size_t index_bytes() const {
+        return super_counts.size() * sizeof(uint64_t) + block_counts.size() * sizeof(uint16_t) +
+               select_samples.size() * sizeof(uint64_t);
+    }
+    
+    // pi(x) for x <= limit(): two index reads plus a popcount of at most
+    // one block
+    uint64_t rank(uint64_t x) const {
+        x = min(x, n);
+        if (x < 7) return (x >= 2) + (x >= 3) + (x >= 5);
+        
+        uint64_t bit = x / 30 * 8;
+        for (int i = 0; i < 8; i++) bit += (g_wheel30.residue[i] <= x % 30);
+        
+        uint64_t block = bit / 512;
+        uint64_t total = 3 + bits_before_block(block);
+        const uint64_t* w = bits.data() + block * BLOCK_WORDS;
+        for (uint64_t i = 0; i < bit % 512 / 64; i++) total += popcount64(w[i]);
+        if (bit % 64) total += popcount64(w[bit % 512 / 64] & ((1ULL << (bit % 64)) - 1));
+        return total;
+    }
+    
+    // The k-th prime (1-based), 0 if k > count(). The sample narrows the
+    // search to the blocks between two samples, a binary search over their
+    // counts finds the block, and a word scan plus PDEP finds the bit.
+    uint64_t select(uint64_t k) const {
+        if (k == 0 || k > count()) return 0;
+        if (k <= small_primes()) return (k == 1) ? 2 : (k == 2) ? 3 : 5;
+        uint64_t r = k - small_primes() - 1;
+        
+        uint64_t sample = r / SELECT_SAMPLE;
+        uint64_t lo = select_samples[sample];
+        uint64_t hi = (sample + 1 < select_samples.size()) ? select_samples[sample + 1] : bits.size() / BLOCK_WORDS - 1;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo + 1) / 2;
+            if (bits_before_block(mid) <= r) lo = mid;
+            else hi = mid - 1;
+        }
+        
+        r -= bits_before_block(lo);
+        const uint64_t* w = bits.data() + lo * BLOCK_WORDS;
+        uint64_t i = 0;
+        for (uint64_t c; r >= (c = popcount64(w[i])); i++) r -= c;
+        
+        uint64_t bit = lo * 512 + i * 64 + select_in_word(w[i], r);
+        return bit / 8 * 30 + g_wheel30.residue[bit % 8];
+    }
+    
+    // True iff x is a prime <= limit()
+    bool contains(uint64_t x) const {
+        if (x > n) return false;
+        if (x < 7) return x == 2 || x == 3 || x == 5;
+        int bit = g_wheel30.bit_of[x % 30];
+        return bit >= 0 && ((bytes()[x / 30] >> bit) & 1);
+    }
+    
+    // out[i] = contains(queries[i]). Lookups are independent, so the only
+    // cost is the cache miss per query; each query's byte is prefetched
+    // PREFETCH_DISTANCE queries ahead to keep that many misses in flight.
+    void contains(const uint64_t* queries, size_t count, bool* out) const {
+        for (size_t i = 0; i < count; i++) {
+            if (i + PREFETCH_DISTANCE < count && queries[i + PREFETCH_DISTANCE] <= n) {
+                _mm_prefetch(reinterpret_cast<const char*>(bytes() + queries[i + PREFETCH_DISTANCE] / 30), _MM_HINT_T0);
+            }
+            out[i] = contains(queries[i]);
+        }
+    }
+};
+
+// ============================================================================
+// Optimized Bit-Packed Sieve with Heavy Loop Unrolling
+// ============================================================================
+
+class BitPackedUnrolledSieve : public ISieve {
+private:
+    // Wheel-30 bytes; 256KB per segment covers 7.8M integers
+    static constexpr uint64_t SEGMENT_BYTES = 262144;
+    static constexpr uint64_t SEGMENT_WORDS = SEGMENT_BYTES / 8;
+    alignas(64) vector<uint64_t> bits;
+    
+    vector<uint64_t> stream_buffer;
+    
+public:
+    // Sieves [lo, hi] segment by segment and hands each finished bitmap to
+    // on_segment(words, word_count, seg_start); 2, 3 and 5 are the
+    // caller's, and bits outside [lo, hi] are already cleared. Every
+    // segment but the last is SEGMENT_BYTES long.
+    template <typename SegmentFn>
+    void sieve_segments(uint64_t lo, uint64_t hi, SegmentFn&& on_segment) {
+        uint64_t first_byte = lo / 30;
+        uint64_t total_bytes = hi / 30 + 1;
+        vector<Wheel30Prime> base = wheel30_sieving_primes(isqrt64(hi), first_byte);
+        
+        bits.assign(SEGMENT_WORDS, 0);
+        uint8_t* seg = reinterpret_cast<uint8_t*>(bits.data());
+        
+        for (uint64_t seg_start = first_byte; seg_start < total_bytes; seg_start += SEGMENT_BYTES) {
+            uint64_t seg_bytes = min(SEGMENT_BYTES, total_bytes - seg_start);
+            uint64_t seg_end = seg_start + seg_bytes;
+            uint64_t words = (seg_bytes + 7) / 8;
+            
+            bits[words - 1] = 0;
+            memset(seg, 0xFF, seg_bytes);
+            if (seg_start == 0) seg[0] &= ~1;  // 1 is not prime
+            
+            // Main sieving, eight wheel steps per unrolled turn; primes whose
+            // square lies past this segment have nothing to do yet
+            for (Wheel30Prime& sp : base) {
+                if ((static_cast<uint64_t>(sp.prime) * sp.prime) / 30 >= seg_end) break;
+                wheel30_cross_off(seg, seg_start, seg_bytes, sp);
+            }
+            
+            // Drop the bits outside [lo, hi] so collection needs no bound check
+            if (seg_start == first_byte) {
+                wheel30_clear_below(seg, seg_start, lo);
+            }
+            if (seg_end == total_bytes) {
+                wheel30_clear_above(seg, seg_start, seg_bytes, hi);
+            }
+            
+            on_segment(bits.data(), words, seg_start);
+        }
+    }
+    
+    static constexpr uint64_t segment_bytes() { return SEGMENT_BYTES; }
+    
+    // The whole bitmap of [0, n] and its rank/select index, for queries
+    // without a list
+    PrimeBitmap bitmap(uint64_t n) {
+        PrimeBitmap result;
+        result.n = n;
+        result.bits.assign((n / 30 + 64) / 64 * PrimeBitmap::BLOCK_WORDS, 0);
+        
+        uint8_t* out = reinterpret_cast<uint8_t*>(result.bits.data());
+        uint64_t total_bytes = n / 30 + 1;
+        sieve_segments(0, n, [&](const uint64_t* words, uint64_t, uint64_t seg_start) {
+            memcpy(out + seg_start, words, min(SEGMENT_BYTES, total_bytes - seg_start));
+        });
+        result.build_index();
+        return result;
+    }
+    
+    vector<uint64_t> sieve(uint64_t n) override {
+        if (n < 2) return {};
+        
+        vector<uint64_t> primes;
+        primes.reserve(prime_count_upper_bound(n) + EXTRACT_SLACK);
+        for (uint64_t p : {2, 3, 5}) {
+            if (p <= n) primes.push_back(p);
+        }
+        
+        // Collect primes with the widest extraction kernel available
+        sieve_segments(0, n, [&](const uint64_t* words, uint64_t count, uint64_t seg_start) {
+            wheel30_append_primes(primes, words, count, seg_start);
+        });
+        
+        return primes;
+    }
+    
+    uint64_t count(uint64_t n) override {
+        if (n < 2) return 0;
+        
+        uint64_t total = (n >= 2) + (n >= 3) + (n >= 5);
+        sieve_segments(0, n, [&](const uint64_t* words, uint64_t count, uint64_t) {
+            total += popcount_words(words, count);
+        });
+        return total;
+    }
+    
+    void for_each_prime(uint64_t lo, uint64_t hi, const PrimeSink& sink) override {
+        if (lo > hi || hi < 2) return;
+        
+        for (uint64_t p : {2, 3, 5}) {
+            if (p >= lo && p <= hi) sink(&p, 1);
+        }
+        sieve_segments(lo, hi, [&](const uint64_t* words, uint64_t count, uint64_t seg_start) {
+            wheel30_stream_primes(words, count, seg_start, stream_buffer, sink);
+        });
+    }
+    
+    const char* name() const override { return "Bit-Packed Unrolled"; }
+};
+
+// ============================================================================
+// AVX2 / AVX-512 Optimized Sieves (When Available)
+// ============================================================================
+
+// One pass per segment: load every group's mask at its phase, AND them
+// together and store, so the segment is written exactly once. The first
+// group replaces the all-ones fill. bytes is a multiple of WIDTH.
+struct Avx2MaskOps {
+    static constexpr uint64_t WIDTH = 32;
+    static const char* name() { return "AVX2 Optimized"; }
+    
+    static void cross_off(uint8_t* seg, uint64_t bytes, const vector<Wheel30MaskGroup>& groups, uint64_t* phase) {
+        size_t num_groups = groups.size();
+        for (uint64_t b = 0; b < bytes; b += WIDTH) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(groups[0].pattern.data() + phase[0]));
+            for (size_t g = 1; g < num_groups; g++) {
+                v = _mm256_and_si256(v, _mm256_loadu_si256((const __m256i*)(groups[g].pattern.data() + phase[g])));
+            }
+            _mm256_storeu_si256((__m256i*)(seg + b), v);
+            
+            for (size_t g = 0; g < num_groups; g++) {
+                phase[g] += WIDTH;
+                if (phase[g] >= groups[g].period) phase[g] -= groups[g].period;
+            }
+        }
+    }
+};
+
+// Same kernel, 64 bytes (512 residues) per step
+struct Avx512MaskOps {
+    static constexpr uint64_t WIDTH = 64;
+    static const char* name() { return "AVX-512 Optimized"; }
+    
+    AVX512_TARGET("avx512f")
+    static void cross_off(uint8_t* seg, uint64_t bytes, const vector<Wheel30MaskGroup>& groups, uint64_t* phase) {
+        size_t num_groups = groups.size();
+        for (uint64_t b = 0; b < bytes; b += WIDTH) {
+            __m512i v = _mm512_loadu_si512(groups[0].pattern.data() + phase[0]);
+            for (size_t g = 1; g < num_groups; g++) {
+                v = _mm512_and_si512(v, _mm512_loadu_si512(groups[g].pattern.data() + phase[g]));
+            }
+            _mm512_storeu_si512(seg + b, v);
+            
+            for (size_t g = 0; g < num_groups; g++) {
+                phase[g] += WIDTH;
+                if (phase[g] >= groups[g].period) phase[g] -= groups[g].period;
+            }
+        }
+    }
+};
+
+// Wheel-30 bit-packed sieve whose small primes come from Ops' combined
+// mask kernel; only the vector width and the kernel differ per engine
+template <typename Ops>
+class Wheel30VectorSieve : public ISieve {
+private:
+    // Same wheel-30 segmentation as the bit-packed sieve, vector aligned
+    static constexpr uint64_t SEGMENT_BYTES = 262144;
+    static constexpr uint64_t SEGMENT_WORDS = SEGMENT_BYTES / 8;
+    static constexpr uint64_t VECTOR_WORDS = Ops::WIDTH / 8;
+    
+    // Primes 7..VECTOR_PRIME_LIMIT are struck a vector at a time from
+    // combined masks; only larger ones take the scalar wheel walk. Wider
+    // masks past 127 measured no better, since their periods fall out of L1
+    static constexpr uint32_t VECTOR_PRIME_LIMIT = 127;
+    static constexpr uint64_t MAX_MASK_PERIOD = 16384;
+    alignas(Ops::WIDTH) vector<uint64_t> bits;
+    vector<Wheel30MaskGroup> groups;
+    vector<uint64_t> phase;  // per group, as many as the limits above produce
+    vector<uint32_t> vector_primes;
+    
+    void init_masks() {
+        if (!groups.empty()) return;
+        groups = wheel30_mask_groups(7, VECTOR_PRIME_LIMIT, MAX_MASK_PERIOD, Ops::WIDTH);
+        phase.resize(groups.size());
+        for (uint32_t p : sieving_primes_up_to(VECTOR_PRIME_LIMIT)) {
+            if (p >= 7) vector_primes.push_back(p);
+        }
+    }
+    
+    void vector_cross_off(uint8_t* seg, uint64_t seg_start, uint64_t bytes) {
+        for (size_t g = 0; g < groups.size(); g++) {
+            phase[g] = seg_start % groups[g].period;
+        }
+        Ops::cross_off(seg, bytes, groups, phase.data());
+    }
+    
+    vector<uint64_t> stream_buffer;
+    
+    // Same contract as BitPackedUnrolledSieve::sieve_segments
+    template <typename SegmentFn>
+    void sieve_segments(uint64_t lo, uint64_t hi, SegmentFn&& on_segment) {
+        init_masks();
+        
+        uint64_t first_byte = lo / 30;
+        uint64_t total_bytes = hi / 30 + 1;
+        vector<Wheel30Prime> base = wheel30_sieving_primes(isqrt64(hi), first_byte);
+        size_t first_scalar = 0;
+        while (first_scalar < base.size() && base[first_scalar].prime <= VECTOR_PRIME_LIMIT) first_scalar++;
+        
+        bits.assign(SEGMENT_WORDS, 0);
+        uint8_t* seg = reinterpret_cast<uint8_t*>(bits.data());
+        
+        for (uint64_t seg_start = first_byte; seg_start < total_bytes; seg_start += SEGMENT_BYTES) {
+            uint64_t seg_bytes = min(SEGMENT_BYTES, total_bytes - seg_start);
+            uint64_t seg_end = seg_start + seg_bytes;
+            uint64_t words = (seg_bytes + 7) / 8;
+            uint64_t aligned_words = ((words + VECTOR_WORDS - 1) / VECTOR_WORDS) * VECTOR_WORDS;
+            
+            // Small primes: mask kernel over the whole vector-aligned range,
+            // then clear the padding it wrote past the segment
+            vector_cross_off(seg, seg_start, aligned_words * 8);
+            memset(seg + seg_bytes, 0, aligned_words * 8 - seg_bytes);
+            
+            if (seg_start == 0) seg[0] &= ~1;  // 1 is not prime
+            for (uint32_t p : vector_primes) {
+                if (p / 30 >= seg_start && p / 30 < seg_end) {
+                    seg[p / 30 - seg_start] |= static_cast<uint8_t>(1u << g_wheel30.bit_of[p % 30]);
+                }
+            }
+            
+            // Larger primes walk the wheel as in the bit-packed sieve
+            for (size_t k = first_scalar; k < base.size(); k++) {
+                Wheel30Prime& sp = base[k];
+                if ((static_cast<uint64_t>(sp.prime) * sp.prime) / 30 >= seg_end) break;
+                wheel30_cross_off(seg, seg_start, seg_bytes, sp);
+            }
+            
+            if (seg_start == first_byte) {
+                wheel30_clear_below(seg, seg_start, lo);
+            }
+            if (seg_end == total_bytes) {
+                wheel30_clear_above(seg, seg_start, seg_bytes, hi);
+            }
+            
+            on_segment(bits.data(), aligned_words, seg_start);
+        }
+    }
+    
+public:
+    vector<uint64_t> sieve(uint64_t n) override {
+        if (n < 2) return {};
+        
+        vector<uint64_t> primes;
+        primes.reserve(prime_count_upper_bound(n) + EXTRACT_SLACK);
+        for (uint64_t p : {2, 3, 5}) {
+            if (p <= n) primes.push_back(p);
+        }
+        
+        sieve_segments(0, n, [&](const uint64_t* words, uint64_t count, uint64_t seg_start) {
+            wheel30_append_primes(primes, words, count, seg_start);
+        });
+        
+        return primes;
+    }
+    
+    uint64_t count(uint64_t n) override {
+        if (n < 2) return 0;
+        
+        uint64_t total = (n >= 2) + (n >= 3) + (n >= 5);
+        sieve_segments(0, n, [&](const uint64_t* words, uint64_t count, uint64_t) {
+            total += popcount_words(words, count);
+        });
+        return total;
+    }
+    
+    void for_each_prime(uint64_t lo, uint64_t hi, const PrimeSink& sink) override {
+        if (lo > hi || hi < 2) return;
+        
+        for (uint64_t p : {2, 3, 5}) {
+            if (p >= lo && p <= hi) sink(&p, 1);
+        }
+        sieve_segments(lo, hi, [&](const uint64_t* words, uint64_t count, uint64_t seg_start) {
+            wheel30_stream_primes(words, count, seg_start, stream_buffer, sink);
+        });
+    }
+    
+    const char* name() const override { return Ops::name(); }
+};
+
+using AVX2OptimizedSieve = Wheel30VectorSieve<Avx2MaskOps>;
+using AVX512OptimizedSieve = Wheel30VectorSieve<Avx512MaskOps>;
+
+// ============================================================================
+// Parallel Segmented Sieve with Work Stealing
+// ============================================================================
+
+inline bool is_prime_u64(uint64_t n);  // Primality Testing, below
+
+// Factorizations of low, low + 1, ..., low + count() - 1: the prime
+// factors of low + i, ascending with multiplicity, are
+// factors[start[i]] .. factors[start[i + 1] - 1]
+struct FactorBlock {
+    uint64_t low = 0;
+    vector<uint32_t> start;
+    vector<uint64_t> factors;
+    
+    size_t count() const { return start.empty() ? 0 : start.size() - 1; }
+};
+
+using FactorSink = function<void(const FactorBlock& block)>;
+
+class ParallelSegmentedSieve : public ISieve {
+private:
+    static constexpr int CACHE_LINE = 64;
+    static constexpr uint64_t SEGMENT_SIZE = 262144;  // 256KB segments
+    static constexpr int SEGMENT_SHIFT = 18;
+    vector<uint32_t> small_primes;
+    uint64_t small_primes_limit = 0;  // small_primes are the primes <= this
+    size_t presieved = 0;    // leading small_primes already in the pattern
+    size_t large_begin = 0;  // first prime > SEGMENT_SIZE in small_primes
+    
+    // Multiples of 2, 3, 5, 7, 11 and 13 repeat every 30030 integers; each
+    // segment starts as a copy of this pattern at its phase instead of
+    // crossing off the densest primes one by one
+    static constexpr uint32_t PRESIEVE_PRIMES[] = {2, 3, 5, 7, 11, 13};
+    static constexpr uint64_t PRESIEVE_PERIOD = 30030;
+    vector<uint8_t> presieve_pattern;
+    
+    struct alignas(CACHE_LINE) WorkUnit {
+        atomic<uint64_t> next_chunk{0};
+        uint64_t max_chunk;
+    };
+    
+    // A large prime waiting for its next multiple, filed under the segment
+    // that multiple falls in (Oliveira e Silva bucket sieve)
+    struct BucketEntry {
+        uint32_t prime;
+        uint32_t offset;  // position of the multiple inside its segment
+    };
+    
+    // Per-worker state for one chunk of consecutive segments. Primes up to
+    // SEGMENT_SIZE carry their next multiple from segment to segment; larger
+    // ones hit a segment at most once and only ever sit in one bucket.
+    struct ChunkState {
+        uint64_t chunk_low;
+        uint64_t chunk_high;
+        vector<uint64_t> next_multiple;  // relative to chunk_low, so it never wraps near 2^64
+        vector<vector<BucketEntry>> buckets;
+    };
+    
+    // Kept across calls with the same bound: near 2^64 the 203 million
+    // primes below 2^32 take far longer to list than to use
+    void set_small_primes(uint64_t limit) {
+        if (!small_primes.empty() && limit == small_primes_limit) return;
+        small_primes_limit = limit;
+        small_primes = sieving_primes_up_to(static_cast<uint32_t>(limit));
+        presieved = upper_bound(small_primes.begin(), small_primes.end(), 13u) - small_primes.begin();
+        large_begin = upper_bound(small_primes.begin(), small_primes.end(), SEGMENT_SIZE) - small_primes.begin();
+    }
+    
+    void init_presieve_pattern() {
+        if (!presieve_pattern.empty()) return;
+        
+        presieve_pattern.assign(PRESIEVE_PERIOD, 1);
+        for (uint32_t p : PRESIEVE_PRIMES) {
+            for (uint64_t i = 0; i < PRESIEVE_PERIOD; i += p) {
+                presieve_pattern[i] = 0;
+            }
+        }
+    }
+    
+    void presieve_fill(uint64_t low, uint64_t size, vector<uint8_t>& segment) {
+        uint64_t phase = low % PRESIEVE_PERIOD;
+        for (uint64_t filled = 0; filled < size; ) {
+            uint64_t chunk = min(size - filled, PRESIEVE_PERIOD - phase);
+            memcpy(segment.data() + filled, presieve_pattern.data() + phase, chunk);
+            filled += chunk;
+            phase = 0;
+        }
+        
+        // The pattern primes themselves went out with their multiples
+        for (uint32_t p : PRESIEVE_PRIMES) {
+            if (p >= low && p - low < size) segment[p - low] = 1;
+        }
+    }
+    
+    // One division per sieving prime per chunk, instead of per segment
+    void init_chunk(uint64_t chunk_low, uint64_t chunk_high, ChunkState& state) {
+        state.chunk_low = chunk_low;
+        state.chunk_high = chunk_high;
+        
+        uint64_t segments = ((chunk_high - chunk_low) >> SEGMENT_SHIFT) + 1;
+        if (state.buckets.size() < segments) state.buckets.resize(segments);
+        for (uint64_t s = 0; s < segments; s++) state.buckets[s].clear();
+        
+        state.next_multiple.resize(large_begin);
+        for (size_t k = presieved; k < small_primes.size(); k++) {
+            uint64_t p = small_primes[k];
+            
+            // First multiple >= max(chunk_low, p * p), as an offset from
+            // chunk_low; offsets past the chunk mean nothing to strike
+            uint64_t rel = (p - chunk_low % p) % p;
+            if (chunk_low < p * p) rel = max(rel, p * p - chunk_low);
+            
+            if (k < large_begin) {
+                state.next_multiple[k] = rel;
+            } else {
+                if (rel > chunk_high - chunk_low) continue;
+                state.buckets[rel >> SEGMENT_SHIFT].push_back(
+                    {static_cast<uint32_t>(p), static_cast<uint32_t>(rel & (SEGMENT_SIZE - 1))});
+            }
+        }
+    }
+    
+    void sieve_segment(uint64_t low, uint64_t high, ChunkState& state, vector<uint8_t>& segment) {
+        uint64_t size = high - low + 1;
+        presieve_fill(low, size, segment);
+        
+        uint64_t seg_rel = low - state.chunk_low;
+        for (size_t k = presieved; k < large_begin; k++) {
+            uint64_t p = small_primes[k];
+            uint64_t start = state.next_multiple[k];
+            if (start - seg_rel >= size) continue;
+            
+            // Unrolled marking loop
+            uint64_t j = start - seg_rel;
+            
+            for (; j + 7 * p < size; j += 8 * p) {
+                segment[j] = 0;
+                segment[j + p] = 0;
+                segment[j + 2*p] = 0;
+                segment[j + 3*p] = 0;
+                segment[j + 4*p] = 0;
+                segment[j + 5*p] = 0;
+                segment[j + 6*p] = 0;
+                segment[j + 7*p] = 0;
+            }
+            
+            for (; j < size; j += p) {
+                segment[j] = 0;
+            }
+            
+            state.next_multiple[k] = seg_rel + j;
+        }
+        
+        // Large primes: only the ones with a multiple here are visited
+        uint64_t seg_idx = (low - state.chunk_low) >> SEGMENT_SHIFT;
+        vector<BucketEntry>& bucket = state.buckets[seg_idx];
+        uint64_t room = state.chunk_high - low;
+        
+        for (const BucketEntry& e : bucket) {
+            segment[e.offset] = 0;
+            
+            uint64_t next = static_cast<uint64_t>(e.offset) + e.prime;
+            if (next <= room) {
+                state.buckets[seg_idx + (next >> SEGMENT_SHIFT)].push_back(
+                    {e.prime, static_cast<uint32_t>(next & (SEGMENT_SIZE - 1))});
+            }
+        }
+        bucket.clear();
+    }
+    
+    // Chunks span about sqrt(hi) so filing the large primes is amortized,
+    // but stay small enough that every core gets work
+    static uint64_t chunk_segments_for(uint64_t lo, uint64_t hi) {
+        uint64_t total_segments = (hi - lo) / SEGMENT_SIZE + 1;
+        uint64_t chunk_segments = max<uint64_t>(8, (isqrt64(hi) >> SEGMENT_SHIFT) + 1);
+        uint64_t per_thread = (total_segments + g_cpu.logical_cores - 1) / g_cpu.logical_cores;
+        return max<uint64_t>(1, min(chunk_segments, per_thread));
+    }
+    
+    // Sieves [lo, hi] (lo >= 2) chunk by chunk across all cores and hands
+    // each finished segment to on_segment(thread_id, low, segment, size),
+    // where segment[i] != 0 iff low + i is prime. small_primes must already
+    // cover sqrt(hi); thread ids are below g_cpu.logical_cores. With
+    // sieve = false the segments are only handed out, segment is null.
+    template <typename SegmentFn>
+    void run_interval(uint64_t lo, uint64_t hi, SegmentFn&& on_segment, bool sieve = true) {
+        init_presieve_pattern();
+        
+        uint64_t total_segments = (hi - lo) / SEGMENT_SIZE + 1;
+        uint64_t chunk_segments = chunk_segments_for(lo, hi);
+        
+        // Setup work units
+        WorkUnit work;
+        work.max_chunk = (total_segments + chunk_segments - 1) / chunk_segments;
+        
+        int num_threads = static_cast<int>(min<uint64_t>(g_cpu.logical_cores, work.max_chunk));
+        vector<thread> threads;
+        
+        auto worker = [&](int thread_id) {
+            vector<uint8_t> segment(sieve ? SEGMENT_SIZE : 0);
+            ChunkState state;
+            
+            while (true) {
+                uint64_t chunk_idx = work.next_chunk.fetch_add(1);
+                if (chunk_idx >= work.max_chunk) break;
+                
+                uint64_t chunk_low = lo + chunk_idx * chunk_segments * SEGMENT_SIZE;
+                uint64_t chunk_high = chunk_low + min(chunk_segments * SEGMENT_SIZE - 1, hi - chunk_low);
+                if (sieve) init_chunk(chunk_low, chunk_high, state);
+                
+                for (uint64_t low = chunk_low; ; low += SEGMENT_SIZE) {
+                    uint64_t high = low + min(SEGMENT_SIZE - 1, chunk_high - low);
+                    
+                    if (sieve) sieve_segment(low, high, state, segment);
+                    on_segment(thread_id, low, sieve ? segment.data() : nullptr, high - low + 1);
+                    
+                    if (high == chunk_high) break;
+                }
+            }
+        };
+        
+        // Launch threads
+        for (int i = 0; i < num_threads; i++) {
+            threads.emplace_back(worker, i);
+        }
+        
+        // Wait for completion
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+    
+    vector<uint64_t> sieve_interval(uint64_t lo, uint64_t hi) {
+        vector<vector<uint64_t>> thread_primes(g_cpu.logical_cores);
+        
+        run_interval(lo, hi, [&](int thread_id, uint64_t low, const uint8_t* segment, uint64_t size) {
+            vector<uint64_t>& local_primes = thread_primes[thread_id];
+            if (local_primes.empty()) local_primes.reserve(SEGMENT_SIZE / 10);
+            
+            // Collect primes
+            append_set_bytes(local_primes, segment, size, low);
+        });
+        
+        // Merge results
+        vector<uint64_t> primes;
+        size_t total = 0;
+        for (const auto& tp : thread_primes) total += tp.size();
+        primes.reserve(total);
+        for (const auto& tp : thread_primes) {
+            primes.insert(primes.end(), tp.begin(), tp.end());
+        }
+        
+        sort(primes.begin(), primes.end());
+        
+        return primes;
+    }
+    
+    // Per-thread totals padded to a cache line each, so the workers'
+    // counters never share one
+    uint64_t count_interval(uint64_t lo, uint64_t hi) {
+        struct alignas(CACHE_LINE) PaddedCount { uint64_t value = 0; };
+        vector<PaddedCount> thread_counts(g_cpu.logical_cores);
+        
+        run_interval(lo, hi, [&](int thread_id, uint64_t, const uint8_t* segment, uint64_t size) {
+            thread_counts[thread_id].value += count_set_bytes(segment, size);
+        });
+        
+        uint64_t total = 0;
+        for (const auto& c : thread_counts) total += c.value;
+        return total;
+    }
+    
+    // Workers finish segments out of order; each finished segment's Block,
+    // from collect(thread_id, low, segment, size, block), is parked until
+    // all earlier ones are delivered, so deliver(block) sees them in order.
+    // A worker more than a few chunks ahead of the emitter waits, which
+    // keeps memory flat however wide [lo, hi] is.
+    template <typename Block, typename CollectFn, typename DeliverFn>
+    void emit_in_order(uint64_t lo, uint64_t hi, CollectFn&& collect, DeliverFn&& deliver, bool sieve = true) {
+        uint64_t window = 4 * static_cast<uint64_t>(g_cpu.logical_cores) *
+                          max<uint64_t>(8, (isqrt64(hi) >> SEGMENT_SHIFT) + 1);
+        mutex emit_lock;
+        condition_variable emitted;
+        uint64_t next_emit = 0;
+        map<uint64_t, Block> parked;
+        
+        run_interval(lo, hi, [&](int thread_id, uint64_t low, const uint8_t* segment, uint64_t size) {
+            Block block;
+            collect(thread_id, low, segment, size, block);
+            
+            uint64_t index = (low - lo) >> SEGMENT_SHIFT;
+            unique_lock<mutex> lock(emit_lock);
+            emitted.wait(lock, [&] { return index - next_emit <= window; });
+            parked.emplace(index, move(block));
+            
+            bool advanced = false;
+            for (auto it = parked.begin(); it != parked.end() && it->first == next_emit; it = parked.erase(it)) {
+                deliver(it->second);
+                next_emit++;
+                advanced = true;
+            }
+            if (advanced) emitted.notify_all();
+        }, sieve);
+    }
+    
+    // emit_in_order for values bound for a PrimeSink
+    template <typename CollectFn>
+    void emit_values_in_order(uint64_t lo, uint64_t hi, const PrimeSink& sink, CollectFn&& collect) {
+        emit_in_order<vector<uint64_t>>(lo, hi, collect, [&](const vector<uint64_t>& values) {
+            if (!values.empty()) sink(values.data(), values.size());
+        });
+    }
+    
+    // Per-worker buffers for factor_segment
+    struct FactorScratch {
+        vector<uint64_t> residual;
+        vector<uint64_t> hits;  // (index << 32) | prime, one per division
+        vector<uint32_t> cursor;
+    };
+    
+    // Factors low .. low + size - 1 into block. Every sieving prime walks
+    // its multiples through a residual array and divides itself out, by
+    // multiplying with its inverse mod 2^64 since the division is exact;
+    // each division is noted as (index, prime). The primes go in ascending
+    // order, so a counting sort by index lays out each number's factors
+    // ascending. A residual left above 1 is the one prime factor above
+    // sqrt(hi).
+    void factor_segment(uint64_t low, uint64_t size, const vector<uint64_t>& inverse,
+                        const vector<uint64_t>& max_quotient, FactorScratch& scratch, FactorBlock& block) const {
+        vector<uint64_t>& residual = scratch.residual;
+        vector<uint64_t>& hits = scratch.hits;
+        residual.resize(size);
+        for (uint64_t i = 0; i < size; i++) residual[i] = low + i;
+        hits.clear();
+        
+        for (uint64_t i = low & 1; i < size; i += 2) {
+            int twos = ctz64(residual[i]);
+            residual[i] >>= twos;
+            for (int t = 0; t < twos; t++) hits.push_back(i << 32 | 2);
+        }
+        
+        for (size_t k = 1; k < small_primes.size(); k++) {
+            uint64_t p = small_primes[k];
+            for (uint64_t i = (p - low % p) % p; i < size; i += p) {
+                uint64_t r = residual[i];
+                do {
+                    r *= inverse[k];
+                    hits.push_back(i << 32 | p);
+                } while (r * inverse[k] <= max_quotient[k]);
+                residual[i] = r;
+            }
+        }
+        
+        block.low = low;
+        block.start.assign(size + 1, 0);
+        for (uint64_t h : hits) block.start[(h >> 32) + 1]++;
+        for (uint64_t i = 0; i < size; i++) block.start[i + 1] += (residual[i] > 1);
+        for (uint64_t i = 0; i < size; i++) block.start[i + 1] += block.start[i];
+        
+        block.factors.resize(block.start[size]);
+        scratch.cursor.assign(block.start.begin(), block.start.end() - 1);
+        for (uint64_t h : hits) block.factors[scratch.cursor[h >> 32]++] = h & 0xFFFFFFFF;
+        for (uint64_t i = 0; i < size; i++) {
+            if (residual[i] > 1) block.factors[scratch.cursor[i]] = residual[i];
+        }
+    }
+    
+    // Offsets start at 0, rise strictly and span less than a segment
+    static bool valid_pattern(const vector<uint32_t>& offsets) {
+        if (offsets.empty() || offsets[0] != 0 || offsets.back() >= SEGMENT_SIZE) return false;
+        for (size_t j = 1; j < offsets.size(); j++) {
+            if (offsets[j] <= offsets[j - 1]) return false;
+        }
+        return true;
+    }
+    
+    // Tuple starts s in [from, to) checked one by one; known[i] is the flag
+    // of known_low + i for known_low + i < known_end, and members at or past
+    // known_end are settled by is_prime_u64. Only used on the few starts
+    // next to a seam.
+    static void resolve_tuples(vector<uint64_t>& out, const uint8_t* known, uint64_t known_low, uint64_t known_end,
+                               uint64_t from, uint64_t to, const vector<uint32_t>& offsets) {
+        for (uint64_t s = from; s < to; s++) {
+            bool all = true;
+            for (size_t j = 0; j < offsets.size() && all; j++) {
+                if (s > ~0ULL - offsets[j]) all = false;
+                else if (s + offsets[j] < known_end) all = known[s + offsets[j] - known_low] != 0;
+                else all = is_prime_u64(s + offsets[j]);
+            }
+            if (all) out.push_back(s);
+        }
+    }
+    
+    // Tuple starts of one segment, ascending. Inside a chunk the segments
+    // come in order on one worker, so the last `span` flags of each are
+    // carried over and ANDed with the first ones of the next; the seam
+    // starts are emitted with the later segment, still in order. The last
+    // segment of a chunk has no follower on its worker and tests its few
+    // members past the end with is_prime_u64.
+    void segment_tuples(vector<uint64_t>& out, vector<uint8_t>& carry, uint64_t lo, uint64_t hi, uint64_t chunk_span,
+                        const vector<uint32_t>& offsets, uint64_t low, const uint8_t* segment, uint64_t size) {
+        uint64_t span = offsets.back();
+        uint64_t chunk_low = low - (low - lo) % chunk_span;
+        uint64_t chunk_high = chunk_low + min(chunk_span - 1, hi - chunk_low);
+        
+        if (low != chunk_low && span > 0) {
+            uint64_t head = min(span, size);
+            carry.insert(carry.end(), segment, segment + head);
+            resolve_tuples(out, carry.data(), low - span, low + head, low - span, low, offsets);
+        }
+        
+        if (size > span) append_shifted_and(out, segment, size - span, offsets.data() + 1, offsets.size() - 1, low);
+        
+        uint64_t tail = min(span, size);
+        if (low + size - 1 == chunk_high) {
+            resolve_tuples(out, segment, low, low + size, low + size - tail, low + size, offsets);
+        } else {
+            carry.assign(segment + size - tail, segment + size);
+        }
+    }
+    
+    template <typename States, typename Reducers, size_t... I>
+    static void fold_primes(States& states, const Reducers& reducers, const vector<uint64_t>& primes, index_sequence<I...>) {
+        auto fold_one = [&](const auto& reducer, auto& state) {
+            for (uint64_t p : primes) reducer.add(state, p);
+        };
+        (fold_one(get<I>(reducers), get<I>(states)), ...);
+    }
+    
+    template <typename States, typename Reducers, size_t... I>
+    static void merge_states(States& left, const States& right, const Reducers& reducers, index_sequence<I...>) {
+        (get<I>(reducers).merge(get<I>(left), get<I>(right)), ...);
+    }
+    
+public:
+    vector<uint64_t> sieve(uint64_t n) override {
+        if (n < 2) return {};
+        
+        // For small n, use bit-packed version
+        if (n < 10000000) {
+            BitPackedUnrolledSieve bp;
+            return bp.sieve(n);
+        }
+        
+        uint64_t sqrt_n = isqrt64(n);
+        
+        // Find small primes up to sqrt(n)
+        set_small_primes(sqrt_n);
+        
+        vector<uint64_t> all_primes(small_primes.begin(), small_primes.end());
+        all_primes.reserve(prime_count_upper_bound(n));
+        
+        vector<uint64_t> rest = sieve_interval(sqrt_n + 1, n);
+        all_primes.insert(all_primes.end(), rest.begin(), rest.end());
+        
+        return all_primes;
+    }
+    
+    // Sieves [lo, hi] (lo >= 2) across all cores, calling on_segment(thread_id,
+    // low, segment, size) for each segment_size() window; segment[i] != 0
+    // iff low + i is prime. Windows arrive in no particular order.
+    template <typename SegmentFn>
+    void sieve_segments(uint64_t lo, uint64_t hi, SegmentFn&& on_segment) {
+        set_small_primes(isqrt64(hi));
+        run_interval(lo, hi, on_segment);
+    }
+    
+    static constexpr uint64_t segment_size() { return SEGMENT_SIZE; }
+    
+    void for_each_prime(uint64_t lo, uint64_t hi, const PrimeSink& sink) override {
+        lo = max<uint64_t>(lo, 2);
+        if (lo > hi) return;
+        
+        set_small_primes(isqrt64(hi));
+        emit_values_in_order(lo, hi, sink, [&](int, uint64_t low, const uint8_t* segment, uint64_t size, vector<uint64_t>& primes) {
+            primes.reserve(count_set_bytes(segment, size));
+            append_set_bytes(primes, segment, size, low);
+        });
+    }
+    
+    // Only sqrt(hi) sieving primes plus the window itself are touched,
+    // so the cost is O(hi - lo + sqrt(hi)) however large lo is
+    vector<uint64_t> sieve_range(uint64_t lo, uint64_t hi) override {
+        lo = max<uint64_t>(lo, 2);
+        if (lo > hi) return {};
+        
+        set_small_primes(isqrt64(hi));
+        return sieve_interval(lo, hi);
+    }
+    
+    uint64_t count(uint64_t n) override {
+        if (n < 10000000) {
+            BitPackedUnrolledSieve bp;
+            return bp.count(n);
+        }
+        
+        uint64_t sqrt_n = isqrt64(n);
+        set_small_primes(sqrt_n);
+        return small_primes.size() + count_interval(sqrt_n + 1, n);
+    }
+    
+    // Folds every prime in [lo, hi] into each reducer in one parallel pass,
+    // with no prime list. A reducer is
+    //     struct R {
+    //         struct State { ... };                         // empty range
+    //         void add(State& s, uint64_t p) const;         // p follows s
+    //         void merge(State& left, const State& right) const;  // right follows left
+    //     };
+    // Each segment is folded into fresh states and merged into its chunk's,
+    // which its worker holds until the chunk is done. Finished chunks are
+    // parked and merged into the total strictly in order as soon as all
+    // earlier ones are in, so reducers that look at neighbours (gaps,
+    // tuples) see the primes in sequence and only the chunks in flight
+    // are held, however wide [lo, hi] is.
+    template <typename... Reducers>
+    tuple<typename Reducers::State...> reduce(uint64_t lo, uint64_t hi, const Reducers&... reducers) {
+        using States = tuple<typename Reducers::State...>;
+        auto all = index_sequence_for<Reducers...>();
+        tuple<const Reducers&...> reducer_refs(reducers...);
+        
+        lo = max<uint64_t>(lo, 2);
+        if (lo > hi) return States();
+        
+        set_small_primes(isqrt64(hi));
+        uint64_t chunk_span = chunk_segments_for(lo, hi) * SEGMENT_SIZE;
+        vector<States> thread_states(g_cpu.logical_cores);
+        vector<vector<uint64_t>> thread_primes(g_cpu.logical_cores);
+        
+        States total;
+        mutex merge_lock;
+        uint64_t next_merge = 0;
+        map<uint64_t, States> parked;
+        
+        run_interval(lo, hi, [&](int thread_id, uint64_t low, const uint8_t* segment, uint64_t size) {
+            vector<uint64_t>& primes = thread_primes[thread_id];
+            primes.clear();
+            append_set_bytes(primes, segment, size, low);
+            
+            States segment_states;
+            fold_primes(segment_states, reducer_refs, primes, all);
+            merge_states(thread_states[thread_id], segment_states, reducer_refs, all);
+            
+            uint64_t chunk = (low - lo) / chunk_span;
+            uint64_t chunk_low = lo + chunk * chunk_span;
+            if (low + (size - 1) != chunk_low + min(chunk_span - 1, hi - chunk_low)) return;
+            
+            lock_guard<mutex> lock(merge_lock);
+            parked.emplace(chunk, move(thread_states[thread_id]));
+            thread_states[thread_id] = States();
+            for (auto it = parked.begin(); it != parked.end() && it->first == next_merge; it = parked.erase(it)) {
+                merge_states(total, it->second, reducer_refs, all);
+                next_merge++;
+            }
+        });
+        
+        return total;
+    }
+    
+    // Prime k-tuples: every p in [lo, hi] with p + o prime for each offset
+    // o, e.g. {0, 2} twins, {0, 4} cousins, {0, 6} sexy pairs, {0, 2, 6}
+    // triplets. Found by ANDing each segment's flags with themselves
+    // shifted by the offsets, so no prime is ever listed. offsets must start
+    // at 0, rise strictly and span less than segment_size(); any other
+    // pattern finds nothing.
+    uint64_t count_tuples(uint64_t lo, uint64_t hi, const vector<uint32_t>& offsets) {
+        lo = max<uint64_t>(lo, 2);
+        if (lo > hi || !valid_pattern(offsets)) return 0;
+        
+        struct alignas(CACHE_LINE) PaddedCount { uint64_t value = 0; };
+        vector<PaddedCount> thread_counts(g_cpu.logical_cores);
+        vector<vector<uint8_t>> thread_carry(g_cpu.logical_cores);
+        vector<vector<uint64_t>> thread_starts(g_cpu.logical_cores);
+        uint64_t chunk_span = chunk_segments_for(lo, hi) * SEGMENT_SIZE;
+        
+        set_small_primes(isqrt64(hi));
+        run_interval(lo, hi, [&](int thread_id, uint64_t low, const uint8_t* segment, uint64_t size) {
+            vector<uint64_t>& starts = thread_starts[thread_id];
+            starts.clear();
+            segment_tuples(starts, thread_carry[thread_id], lo, hi, chunk_span, offsets, low, segment, size);
+            thread_counts[thread_id].value += starts.size();
+        });
+        
+        uint64_t total = 0;
+        for (const auto& c : thread_counts) total += c.value;
+        return total;
+    }
+    
+    // The tuple starts of count_tuples, ascending, streamed like
+    // for_each_prime
+    void for_each_tuple(uint64_t lo, uint64_t hi, const vector<uint32_t>& offsets, const PrimeSink& sink) {
+        lo = max<uint64_t>(lo, 2);
+        if (lo > hi || !valid_pattern(offsets)) return;
+        
+        vector<vector<uint8_t>> thread_carry(g_cpu.logical_cores);
+        uint64_t chunk_span = chunk_segments_for(lo, hi) * SEGMENT_SIZE;
+        
+        set_small_primes(isqrt64(hi));
+        emit_values_in_order(lo, hi, sink, [&](int thread_id, uint64_t low, const uint8_t* segment, uint64_t size, vector<uint64_t>& starts) {
+            segment_tuples(starts, thread_carry[thread_id], lo, hi, chunk_span, offsets, low, segment, size);
+        });
+    }
+    
+    // Full factorization of every integer in [lo, hi] (lo >= 2), one
+    // FactorBlock per segment handed to sink in order. The sieving primes
+    // divide their multiples out of a residual array instead of crossing
+    // them off, so each number costs a few multiplications per factor
+    // rather than a trial division up to its square root.
+    void factor_range(uint64_t lo, uint64_t hi, const FactorSink& sink) {
+        lo = max<uint64_t>(lo, 2);
+        if (lo > hi) return;
+        
+        set_small_primes(isqrt64(hi));
+        vector<uint64_t> inverse(small_primes.size()), max_quotient(small_primes.size());
+        for (size_t k = 1; k < small_primes.size(); k++) {
+            uint64_t p = small_primes[k];
+            uint64_t inv = p;
+            for (int i = 0; i < 5; i++) inv *= 2 - p * inv;  // Newton, bits double
+            inverse[k] = inv;
+            max_quotient[k] = ~0ULL / p;
+        }
+        
+        vector<FactorScratch> thread_scratch(g_cpu.logical_cores);
+        emit_in_order<FactorBlock>(lo, hi,
+            [&](int thread_id, uint64_t low, const uint8_t*, uint64_t size, FactorBlock& block) {
+                factor_segment(low, size, inverse, max_quotient, thread_scratch[thread_id], block);
+            },
+            [&](const FactorBlock& block) { sink(block); },
+            false);
+    }
+    
+    // A pattern is admissible if it misses some residue class mod every
+    // prime, i.e. nothing forces one member to be a multiple of p for all
+    // large starts; only admissible patterns can have infinitely many
+    // occurrences. Primes above the tuple size never cover all classes.
+    static bool is_admissible(const vector<uint32_t>& offsets) {
+        for (uint32_t p : sieving_primes_up_to(static_cast<uint32_t>(max<size_t>(offsets.size(), 2)))) {
+            vector<bool> hit(p, false);
+            size_t classes = 0;
+            for (uint32_t o : offsets) {
+                if (!hit[o % p]) { hit[o % p] = true; classes++; }
+            }
+            if (classes == p) return false;
+        }
+        return true;
+    }
+    
+    // Lazy input range of the primes >= x, in order:
+    //     for (uint64_t p : ParallelSegmentedSieve::primes_from(x)) { if (done(p)) break; }
+    class PrimeGenerator;
+    static PrimeGenerator primes_from(uint64_t x);
+    
+    const char* name() const override { return "Parallel Segmented"; }
+};
+
+// Each segment is sieved only when the previous one is used up. Within a
+// chunk the sieving primes keep their next multiples and bucket slots from
+// segment to segment, so resuming costs nothing; a new chunk re-primes them
+// and widens the sieving primes as sqrt grows. The range ends after the
+// largest 64-bit prime.
+class ParallelSegmentedSieve::PrimeGenerator {
+public:
+    class iterator {
+    public:
+        using iterator_category = input_iterator_tag;
+        using value_type = uint64_t;
+        using difference_type = ptrdiff_t;
+        using pointer = const uint64_t*;
+        using reference = const uint64_t&;
+        
+        explicit iterator(PrimeGenerator* gen = nullptr) : gen(gen) {}
+        reference operator*() const { return gen->primes[gen->pos]; }
+        iterator& operator++() {
+            if (!gen->advance()) gen = nullptr;
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        bool operator==(const iterator& other) const { return gen == other.gen; }
+        bool operator!=(const iterator& other) const { return gen != other.gen; }
+    
+    private:
+        PrimeGenerator* gen;
+    };
+    
+    explicit PrimeGenerator(uint64_t x) : next_low(max<uint64_t>(x, 2)), segment(SEGMENT_SIZE) {
+        sieve.init_presieve_pattern();
+    }
+    
+    // Single pass: begin() starts where the last iteration stopped
+    iterator begin() { return iterator(pos < primes.size() || advance() ? this : nullptr); }
+    iterator end() { return iterator(); }
+    
+private:
+    ParallelSegmentedSieve sieve;
+    ChunkState state;
+    uint64_t next_low;        // first number not yet sieved
+    uint64_t chunk_high = 0;  // last number of the current chunk
+    uint64_t covered = 0;     // the sieving primes reach sqrt(covered)
+    bool started = false;
+    bool exhausted = false;
+    vector<uint8_t> segment;
+    vector<uint64_t> primes;  // primes of the current segment
+    size_t pos = 0;
+    
+    void start_chunk() {
+        uint64_t chunk_segments = max<uint64_t>(8, (isqrt64(next_low) >> SEGMENT_SHIFT) + 1);
+        chunk_high = next_low + min<uint64_t>(chunk_segments * SEGMENT_SIZE - 1, ~0ULL - next_low);
+        
+        // Widen at least 4x at a time so the sieving primes are rarely rebuilt
+        if (covered < chunk_high) {
+            covered = (max(chunk_high, covered) > (~0ULL >> 2)) ? ~0ULL : max(chunk_high, covered * 4);
+            sieve.set_small_primes(isqrt64(covered));
+        }
+        sieve.init_chunk(next_low, chunk_high, state);
+    }
+    
+    // Moves to the next prime, sieving segments until one has any;
+    // false once the 64-bit range is used up
+    bool advance() {
+        if (started && ++pos < primes.size()) return true;
+        started = true;
+        
+        while (!exhausted) {
+            if (next_low > chunk_high) start_chunk();
+            
+            uint64_t low = next_low;
+            uint64_t high = low + min(SEGMENT_SIZE - 1, chunk_high - low);
+            sieve.sieve_segment(low, high, state, segment);
+            
+            primes.clear();
+            append_set_bytes(primes, segment.data(), high - low + 1, low);
+            
+            if (high == ~0ULL) exhausted = true;
+            else next_low = high + 1;
+            
+            pos = 0;
+            if (!primes.empty()) return true;
+        }
+        return false;
+    }
+};
+
+inline ParallelSegmentedSieve::PrimeGenerator ParallelSegmentedSieve::primes_from(uint64_t x) {
+    return PrimeGenerator(x);
+}
+
+// ============================================================================
+// Segment Reducers
+// ============================================================================
+// Statistics for ParallelSegmentedSieve::reduce; any number of them come
+// out of one pass:
+//     auto [count, sum, gap] = ParallelSegmentedSieve().reduce(lo, hi,
+//         PrimeCountReducer(), PrimeSumReducer(), MaxGapReducer());
+
+// Unsigned 128-bit accumulator for sums that outgrow 64 bits
+struct UInt128 {
+    uint64_t low = 0;
+    uint64_t high = 0;
+    
+    void add(uint64_t value) {
+        low += value;
+        high += (low < value);
+    }
+    
+    void add(const UInt128& other) {
+        add(other.low);
+        high += other.high;
+    }
+    
+    // Nine decimal digits at a time, by long division of 32-bit limbs
+    string to_string() const {
+        uint32_t limbs[4] = {static_cast<uint32_t>(high >> 32), static_cast<uint32_t>(high),
+                             static_cast<uint32_t>(low >> 32), static_cast<uint32_t>(low)};
+        string digits;
+        while (limbs[0] | limbs[1] | limbs[2] | limbs[3]) {
+            uint64_t rem = 0;
+            for (uint32_t& limb : limbs) {
+                uint64_t cur = (rem << 32) | limb;
+                limb = static_cast<uint32_t>(cur / 1000000000);
+                rem = cur % 1000000000;
+            }
+            for (int i = 0; i < 9; i++, rem /= 10) digits += static_cast<char>('0' + rem % 10);
+        }
+        while (digits.size() > 1 && digits.back() == '0') digits.pop_back();
+        if (digits.empty()) digits = "0";
+        return string(digits.rbegin(), digits.rend());
+    }
+};
+
+struct PrimeCountReducer {
+    struct State { uint64_t count = 0; };
+    void add(State& s, uint64_t) const { s.count++; }
+    void merge(State& left, const State& right) const { left.count += right.count; }
+};
+
+struct PrimeSumReducer {
+    struct State { UInt128 sum; };
+    void add(State& s, uint64_t p) const { s.sum.add(p); }
+    void merge(State& left, const State& right) const { left.sum.add(right.sum); }
+};
+
+struct PrimeSquareSumReducer {
+    struct State { UInt128 sum; };
+    void add(State& s, uint64_t p) const {
+        UInt128 square;
+        square.low = mul_wide64(p, p, square.high);
+        s.sum.add(square);
+    }
+    void merge(State& left, const State& right) const { left.sum.add(right.sum); }
+};
+
+// Largest gap between consecutive primes, and the prime it follows (the
+// first such prime on ties). Gaps across a merge come from the seam.
+struct MaxGapReducer {
+    struct State {
+        uint64_t first = 0;  // 0 while the range holds no prime
+        uint64_t last = 0;
+        uint64_t gap = 0;
+        uint64_t gap_low = 0;
+    };
+    
+    void add(State& s, uint64_t p) const {
+        if (!s.first) s.first = p;
+        else if (p - s.last > s.gap) {
+            s.gap = p - s.last;
+            s.gap_low = s.last;
+        }
+        s.last = p;
+    }
+    
+    void merge(State& left, const State& right) const {
+        if (!right.first) return;
+        if (!left.first) {
+            left = right;
+            return;
+        }
+        if (right.first - left.last > left.gap) {
+            left.gap = right.first - left.last;
+            left.gap_low = left.last;
+        }
+        if (right.gap > left.gap) {
+            left.gap = right.gap;
+            left.gap_low = right.gap_low;
+        }
+        left.last = right.last;
+    }
+};
+
+// First-occurrence record gaps: every gap larger than all gaps before it
+// in the range, with the prime it follows. A state keeps the records of
+// its own stretch, which are few (about log of its length); a merge keeps
+// the seam gap and the right-hand records that beat the left's largest.
+struct RecordGapReducer {
+    struct Record {
+        uint64_t gap;
+        uint64_t low;  // the gap runs from low to low + gap
+    };
+    
+    struct State {
+        uint64_t first = 0;  // 0 while the range holds no prime
+        uint64_t last = 0;
+        vector<Record> records;  // gaps rising
+    };
+    
+    static void offer(State& s, uint64_t gap, uint64_t low) {
+        if (s.records.empty() || gap > s.records.back().gap) s.records.push_back({gap, low});
+    }
+    
+    void add(State& s, uint64_t p) const {
+        if (!s.first) s.first = p;
+        else offer(s, p - s.last, s.last);
+        s.last = p;
+    }
+    
+    void merge(State& left, const State& right) const {
+        if (!right.first) return;
+        if (!left.first) {
+            left = right;
+            return;
+        }
+        offer(left, right.first - left.last, left.last);
+        for (const Record& r : right.records) offer(left, r.gap, r.low);
+        left.last = right.last;
+    }
+};
+
+// ============================================================================
+// Wheel Factorization Sieve (Memory Efficient for Huge Ranges)
+// ============================================================================
+
+class WheelFactorizationSieve : public ISieve {
+private:
+    static constexpr int WHEEL[] = {2, 3, 5, 7, 11, 13};
+    static constexpr int WHEEL_SIZE = 30030;  // Product of first 6 primes
+    static constexpr int RESIDUE_COUNT = 5760;  // phi(30030): 19% of all integers
+    static constexpr int TURN_WORDS = RESIDUE_COUNT / 64;  // 90 words per turn
+    static constexpr uint64_t WINDOW_TURNS = 64;  // ~45KB window, 1.9M integers
+    
+    // Only residues coprime to the wheel are stored; bit k of a turn stands
+    // for turn * WHEEL_SIZE + residues[k]
+    vector<uint16_t> residues;
+    vector<uint8_t> gaps;        // residues[k + 1] - residues[k], wrapping
+    vector<int16_t> index_of;    // residue -> bit, -1 if it shares a factor
+    
+    // Sieving prime at multiple value = p * m, with m at wheel position k
+    struct WheelPrime {
+        uint64_t prime;
+        uint64_t value;
+        uint32_t k;
+    };
+    
+    void init_wheel() {
+        if (!residues.empty()) return;
+        
+        index_of.assign(WHEEL_SIZE, -1);
+        for (int r = 1; r < WHEEL_SIZE; r++) {
+            bool coprime = true;
+            for (int p : WHEEL) {
+                if (r % p == 0) {
+                    coprime = false;
+                    break;
+                }
+            }
+            if (coprime) {
+                index_of[r] = static_cast<int16_t>(residues.size());
+                residues.push_back(static_cast<uint16_t>(r));
+            }
+        }
+        
+        gaps.resize(RESIDUE_COUNT);
+        for (int k = 0; k < RESIDUE_COUNT; k++) {
+            int next = (k + 1 < RESIDUE_COUNT) ? residues[k + 1] : WHEEL_SIZE + residues[0];
+            gaps[k] = static_cast<uint8_t>(next - residues[k]);
+        }
+    }
+    
+    // Sieves [0, n] window by window and hands each finished window to
+    // on_window(words, word_count, first_turn); the wheel primes are the
+    // caller's, and residues past n are already cleared
+    template <typename WindowFn>
+    void sieve_windows(uint64_t n, WindowFn&& on_window) {
+        init_wheel();
+        
+        // Remaining sieving primes start after the wheel primes, at p * p
+        vector<WheelPrime> base;
+        for (uint32_t p : sieving_primes_up_to(static_cast<uint32_t>(isqrt64(n)))) {
+            if (p <= 13) continue;
+            base.push_back({p, static_cast<uint64_t>(p) * p, static_cast<uint32_t>(index_of[p % WHEEL_SIZE])});
+        }
+        
+        uint64_t total_turns = n / WHEEL_SIZE + 1;
+        vector<uint64_t> window(WINDOW_TURNS * TURN_WORDS);
+        
+        for (uint64_t turn = 0; turn < total_turns; turn += WINDOW_TURNS) {
+            uint64_t turns = min(WINDOW_TURNS, total_turns - turn);
+            uint64_t words = turns * TURN_WORDS;
+            uint64_t window_end = (turn + turns) * WHEEL_SIZE;  // first value past the window
+            
+            // Multiples of 2..13 were never stored, so every bit starts set
+            fill(window.begin(), window.begin() + words, 0xFFFFFFFFFFFFFFFFULL);
+            if (turn == 0) window[0] &= ~1ULL;  // 1 is not prime
+            
+            // Continue sieving for remaining primes, in residue-indexed space
+            for (WheelPrime& wp : base) {
+                if (wp.prime * wp.prime >= window_end) break;
+                
+                uint64_t value = wp.value;
+                uint32_t k = wp.k;
+                while (value < window_end) {
+                    uint64_t bit = (value / WHEEL_SIZE - turn) * RESIDUE_COUNT + index_of[value % WHEEL_SIZE];
+                    window[bit >> 6] &= ~(1ULL << (bit & 63));
+                    
+                    value += wp.prime * gaps[k];
+                    if (++k == RESIDUE_COUNT) k = 0;
+                }
+                wp.value = value;
+                wp.k = k;
+            }
+            
+            // Drop residues past n in the final turn
+            if (turn + turns == total_turns) {
+                uint64_t last_turn = total_turns - 1;
+                for (int k = RESIDUE_COUNT - 1; k >= 0 && last_turn * WHEEL_SIZE + residues[k] > n; k--) {
+                    uint64_t bit = (last_turn - turn) * RESIDUE_COUNT + k;
+                    window[bit >> 6] &= ~(1ULL << (bit & 63));
+                }
+            }
+            
+            on_window(window.data(), words, turn);
+        }
+    }
+    
+public:
+    vector<uint64_t> sieve(uint64_t n) override {
+        if (n < 2) return {};
+        
+        vector<uint64_t> primes;
+        primes.reserve(prime_count_upper_bound(n));
+        for (int p : WHEEL) {
+            if (static_cast<uint64_t>(p) <= n) primes.push_back(p);
+        }
+        
+        // Collect primes
+        sieve_windows(n, [&](const uint64_t* window, uint64_t words, uint64_t turn) {
+            for (uint64_t w = 0; w < words; w++) {
+                uint64_t word = window[w];
+                uint64_t turn_value = (turn + w / TURN_WORDS) * WHEEL_SIZE;
+                int bit_base = static_cast<int>(w % TURN_WORDS) * 64;
+                while (word) {
+                    primes.push_back(turn_value + residues[bit_base + ctz64(word)]);
+                    word &= word - 1;
+                }
+            }
+        });
+        
+        return primes;
+    }
+    
+    uint64_t count(uint64_t n) override {
+        if (n < 2) return 0;
+        
+        uint64_t total = 0;
+        for (int p : WHEEL) {
+            if (static_cast<uint64_t>(p) <= n) total++;
+        }
+        sieve_windows(n, [&](const uint64_t* window, uint64_t words, uint64_t) {
+            total += popcount_words(window, words);
+        });
+        return total;
+    }
+    
+    const char* name() const override { return "Wheel Factorization"; }
+};
+
+// ============================================================================
+// Smallest Prime Factor Table
+// ============================================================================
+// Factoring by table lookup: every n <= limit coprime to 30 (8 of each 30
+// integers, in wheel-30 order) gets the index of its smallest prime factor
+// among the primes 7..sqrt(limit), 16 bits each, 0 for primes. 2, 3 and 5
+// are divided out by hand, and the cofactor stays coprime to 30, so each
+// further factor is one lookup. To 1e9 that is 533 MB, where an int per
+// integer takes 4 GB.
+
+class SpfTableSieve : public ISieve {
+private:
+    static constexpr uint64_t SEGMENT_BYTES = 16384;   // wheel bytes per build segment, 256KB of entries
+    static constexpr uint64_t MAX_LIMIT = 1ULL << 36;  // keeps the factor index within 16 bits
+    
+    uint64_t limit = 0;
+    vector<uint32_t> factor_primes;  // entry k stands for factor_primes[k - 1]
+    vector<uint16_t> spf;            // 8 entries per wheel byte
+    
+    static uint64_t entry_of(uint64_t x) {
+        return (x / 30) * 8 + g_wheel30.bit_of[x % 30];
+    }
+    
+    // Entries [8 * byte_low, 8 * byte_high). Primes go largest first and
+    // overwrite, so the smallest factor is written last. A prime p = 30q + r
+    // strikes p * m for m = 30j + residue[i], whose entries step by 8p as j
+    // grows: eight progressions per prime, no bit tables.
+    void build_segment(uint64_t byte_low, uint64_t byte_high) {
+        uint64_t entry_low = byte_low * 8;
+        uint64_t entry_high = byte_high * 8;
+        fill(spf.begin() + entry_low, spf.begin() + entry_high, 0);
+        
+        uint64_t value_high = byte_high * 30;
+        for (size_t k = factor_primes.size(); k-- > 0; ) {
+            uint64_t p = factor_primes[k];
+            if (p * p >= value_high) continue;
+            uint16_t index = static_cast<uint16_t>(k + 1);
+            uint64_t stride = 8 * p;
+            
+            for (int i = 0; i < 8; i++) {
+                uint64_t r = g_wheel30.residue[i];
+                uint64_t first = entry_of(p * r);
+                
+                // m >= p, so p is a factor only from p * p on
+                uint64_t j = (p > r) ? (p - r + 29) / 30 : 0;
+                if (entry_low > first) j = max(j, (entry_low - first + stride - 1) / stride);
+                
+                for (uint64_t e = first + j * stride; e < entry_high; e += stride) spf[e] = index;
+            }
+        }
+    }
+    
+public:
+    // Table for [0, n], built segment by segment across all cores. n past
+    // MAX_LIMIT is rejected and the table is left as it was.
+    bool build(uint64_t n) {
+        if (n > MAX_LIMIT) return false;
+        limit = n;
+        factor_primes.clear();
+        for (uint32_t p : sieving_primes_up_to(static_cast<uint32_t>(isqrt64(limit)))) {
+            if (p > 5) factor_primes.push_back(p);
+        }
+        
+        uint64_t total_bytes = limit / 30 + 1;
+        spf.assign(total_bytes * 8, 0);
+        spf.shrink_to_fit();
+        
+        uint64_t num_segments = (total_bytes + SEGMENT_BYTES - 1) / SEGMENT_BYTES;
+        atomic<uint64_t> next_segment{0};
+        auto worker = [&]() {
+            for (uint64_t k; (k = next_segment.fetch_add(1)) < num_segments; ) {
+                build_segment(k * SEGMENT_BYTES, min(total_bytes, (k + 1) * SEGMENT_BYTES));
+            }
+        };
+        
+        vector<thread> pool;
+        uint64_t threads = min<uint64_t>(g_cpu.logical_cores, num_segments);
+        for (uint64_t t = 0; t < threads; t++) pool.emplace_back(worker);
+        for (auto& t : pool) t.join();
+        return true;
+    }
+    
+    uint64_t bound() const { return limit; }
+    size_t memory_bytes() const { return spf.capacity() * sizeof(uint16_t); }
+    
+    // Smallest prime factor of 2 <= x <= bound(); x itself if prime
+    uint64_t smallest_factor(uint64_t x) const {
+        if (!(x & 1)) return 2;
+        if (x % 3 == 0) return 3;
+        if (x % 5 == 0) return 5;
+        uint16_t k = spf[entry_of(x)];
+        return k ? factor_primes[k - 1] : x;
+    }
+    
+    // Appends the prime factors of 1 <= x <= bound(), ascending with
+    // multiplicity: one lookup and one division per factor past 2, 3, 5
+    void factor(uint64_t x, vector<uint64_t>& out) const {
+        for (uint64_t p : {2, 3, 5}) {
+            while (x % p == 0) {
+                out.push_back(p);
+                x /= p;
+            }
+        }
+        while (x > 1) {
+            uint16_t k = spf[entry_of(x)];
+            if (!k) {
+                out.push_back(x);
+                break;
+            }
+            out.push_back(factor_primes[k - 1]);
+            x /= factor_primes[k - 1];
+        }
+    }
+    
+    vector<uint64_t> factor(uint64_t x) const {
+        vector<uint64_t> factors;
+        factor(x, factors);
+        return factors;
+    }
+    
+    // The table doubles as a sieve: primes are the zero entries
+    // Past MAX_LIMIT: empty, rather than a truncated list
+    vector<uint64_t> sieve(uint64_t n) override {
+        if (n < 2 || n > MAX_LIMIT) return {};
+        if (n > limit) build(n);
+        
+        vector<uint64_t> primes;
+        primes.reserve(prime_count_upper_bound(n));
+        for (uint64_t p : {2, 3, 5}) {
+            if (p <= n) primes.push_back(p);
+        }
+        for (uint64_t b = 0; b <= n / 30; b++) {
+            for (int i = 0; i < 8; i++) {
+                uint64_t v = b * 30 + g_wheel30.residue[i];
+                if (v > n) break;
+                if (v > 1 && !spf[b * 8 + i]) primes.push_back(v);
+            }
+        }
+        return primes;
+    }
+    
+    // Past MAX_LIMIT: 0, rather than pi(MAX_LIMIT)
+    uint64_t count(uint64_t n) override {
+        if (n < 2 || n > MAX_LIMIT) return 0;
+        if (n > limit) build(n);
+        
+        uint64_t total = (n >= 2) + (n >= 3) + (n >= 5);
+        for (uint64_t b = 0; b <= n / 30; b++) {
+            for (int i = 0; i < 8; i++) {
+                uint64_t v = b * 30 + g_wheel30.residue[i];
+                if (v > n) break;
+                total += (v > 1 && !spf[b * 8 + i]);
+            }
+        }
+        return total;
+    }
+    
+    const char* name() const override { return "SPF Table"; }
+};
+
+// ============================================================================
+// LMO Prime Counting (Sublinear pi(x))
+// ============================================================================
+// Lagarias-Miller-Odlyzko, with the Deleglise-Rivat split of the leaves:
+//   pi(x) = phi(x, a) + a - 1 - P2(x, a),   a = pi(y),   y ~ alpha x^(1/3)
+// Ordinary leaves (n <= y) use a closed form for phi(., 6). Special leaves
+// x / (p m) below p^2 read pi() from a table ("easy"); the rest ("hard")
+// are counted in a segmented sieve of [0, x / y] carrying phi per prime
+// level. P2 needs pi() up to x / y and runs on ParallelSegmentedSieve.
+// Work is about x^(2/3) instead of x; exact for x up to MAX_X = 1e17.
+
+class LMOPrimeCounter : public ISieve {
+public:
+    // Largest x counted exactly; count() returns 0 past it
+    static constexpr uint64_t MAX_X = 100000000000000000ULL;
+    
+private:
+    static constexpr uint64_t MIN_X = 100000000;  // below this, sieving wins
+    
+    // phi(v, C) for the first C primes 2..13 is periodic in 30030
+    static constexpr uint64_t C = 6;
+    static constexpr uint64_t PHI_PERIOD = 30030;
+    static constexpr uint64_t PHI_TOTIENT = 5760;
+    
+    // Hard-leaf segments hold odd numbers only, one bit each, with a
+    // running counter per 1024 bits so leaf queries popcount a few words
+    static constexpr uint64_t SEGMENT_BITS = 1 << 19;
+    static constexpr uint64_t SEGMENT_SPAN = SEGMENT_BITS * 2;
+    static constexpr uint64_t SEGMENT_WORDS = SEGMENT_BITS / 64;
+    static constexpr int COUNTER_SHIFT = 10;
+    static constexpr uint64_t COUNTER_WORDS = (1 << COUNTER_SHIFT) / 64;
+    static constexpr uint64_t COUNTERS = SEGMENT_BITS >> COUNTER_SHIFT;
+    static constexpr uint64_t PRESIEVE_WORDS = PHI_PERIOD / 2;  // 3*5*7*11*13
+    
+    uint64_t x = 0;
+    uint64_t y = 0;
+    uint64_t z = 0;       // x / y, the extent of the hard-leaf sieve
+    uint64_t sqrt_y = 0;
+    uint64_t a = 0;       // pi(y)
+    uint64_t b_hard = 0;  // primes p_{C+1} .. p_{b_hard} have hard leaves
+    
+    vector<uint32_t> primes;  // all primes up to sqrt(x); p_b = primes[b - 1]
+    vector<uint32_t> lpf;     // least prime factor up to y, lpf[1] = max
+    vector<int8_t> mu;        // Moebius function up to y
+    vector<uint16_t> phi_small;        // phi(r, C) for r < PHI_PERIOD
+    vector<uint64_t> presieve_pattern; // odd-only words with 3..13 struck
+    
+    // pi(n) for n up to sqrt(x): per 64 integers, the primes below them
+    // and one bit per odd number in the block
+    struct PiEntry {
+        uint32_t count;
+        uint32_t odd_bits;
+    };
+    vector<PiEntry> pi_table;
+    
+    uint64_t pi(uint64_t n) const {
+        if (n < 2) return 0;
+        const PiEntry& e = pi_table[n >> 6];
+        uint32_t odd_numbers = static_cast<uint32_t>((n & 63) + 1) >> 1;
+        return e.count + popcount64(e.odd_bits & ((1ULL << odd_numbers) - 1));
+    }
+    
+    static uint64_t icbrt64(uint64_t n) {
+        uint64_t r = static_cast<uint64_t>(cbrt(static_cast<double>(n)));
+        while (r * r * r > n) r--;
+        while ((r + 1) * (r + 1) * (r + 1) <= n) r++;
+        return r;
+    }
+    
+    uint64_t phi_tiny(uint64_t v) const {
+        return (v / PHI_PERIOD) * PHI_TOTIENT + phi_small[v % PHI_PERIOD];
+    }
+    
+    void init_tables() {
+        uint64_t sqrt_x = isqrt64(x);
+        primes = sieving_primes_up_to(static_cast<uint32_t>(sqrt_x));
+        
+        pi_table.assign(sqrt_x / 64 + 2, {0, 0});  // P2 asks slightly past sqrt(x)
+        for (uint32_t p : primes) {
+            if (p > 2) pi_table[p >> 6].odd_bits |= 1u << ((p & 63) >> 1);
+        }
+        pi_table[0].count = 1;  // the prime 2; pi() handles n < 2
+        for (size_t k = 1; k < pi_table.size(); k++) {
+            pi_table[k].count = pi_table[k - 1].count + popcount64(pi_table[k - 1].odd_bits);
+        }
+        
+        lpf.assign(y + 1, 0);
+        mu.assign(y + 1, 1);
+        for (uint32_t p : primes) {
+            if (p > y) break;
+            for (uint64_t m = p; m <= y; m += p) {
+                if (!lpf[m]) lpf[m] = p;
+                mu[m] = static_cast<int8_t>(-mu[m]);
+            }
+            for (uint64_t m = static_cast<uint64_t>(p) * p; m <= y; m += static_cast<uint64_t>(p) * p) {
+                mu[m] = 0;
+            }
+        }
+        lpf[1] = 0xFFFFFFFFu;
+        
+        if (phi_small.empty()) {
+            phi_small.resize(PHI_PERIOD);
+            uint16_t coprime = 0;
+            for (uint64_t r = 0; r < PHI_PERIOD; r++) {
+                if (r % 2 && r % 3 && r % 5 && r % 7 && r % 11 && r % 13) coprime++;
+                phi_small[r] = coprime;
+            }
+            
+            // Word w covers the odd numbers 128w + 1 .. 128w + 127
+            presieve_pattern.assign(PRESIEVE_WORDS, 0);
+            for (uint64_t w = 0; w < PRESIEVE_WORDS; w++) {
+                for (uint64_t i = 0; i < 64; i++) {
+                    uint64_t v = 128 * w + 2 * i + 1;
+                    if (v % 3 && v % 5 && v % 7 && v % 11 && v % 13) presieve_pattern[w] |= 1ULL << i;
+                }
+            }
+        }
+    }
+    
+    // Ordinary leaves: sum of mu(n) phi(x / n, C) over n <= y with lpf(n) > 13
+    int64_t s1() const {
+        int64_t sum = 0;
+        for (uint64_t n = 1; n <= y; n++) {
+            if (mu[n] && lpf[n] > 13) sum += mu[n] * static_cast<int64_t>(phi_tiny(x / n));
+        }
+        return sum;
+    }
+    
+    // Easy and trivial leaves of p_b > sqrt(y): m is a prime q in (p, y],
+    // and x / (p q) < p^2 leaves only 1 and primes >= p unsieved, so
+    // phi(x / (p q), b - 1) = pi(x / (p q)) - b + 2, or 1 once x / (p q) < p.
+    // Runs of q sharing pi(x / (p q)) are summed at once.
+    int64_t easy_leaves(uint64_t b) const {
+        uint64_t p = primes[b - 1];
+        uint64_t q_lo = max(p, x / p / p / p);  // q <= x / p^3 is a hard leaf
+        if (q_lo >= y) return 0;
+        
+        uint64_t trivial_lo = max(q_lo, min(y, x / p / p));
+        int64_t sum = static_cast<int64_t>(pi(y) - pi(trivial_lo));
+        
+        uint64_t l = pi(trivial_lo);
+        uint64_t l_lo = pi(q_lo);
+        while (l > l_lo) {
+            uint64_t n = x / p / primes[l - 1];
+            uint64_t pi_n = pi(n);
+            
+            // Every q > x / (p * next prime after n) gives the same pi
+            uint64_t l_next = l - 1;
+            if (pi_n < primes.size()) {
+                l_next = max(l_lo, pi(x / p / primes[pi_n]));
+            }
+            sum += static_cast<int64_t>(l - l_next) * static_cast<int64_t>(pi_n - b + 2);
+            l = l_next;
+        }
+        return sum;
+    }
+    
+    // Largest b whose hard leaves can reach low: p_b <= sqrt(y) reach up
+    // to x / y, larger p only up to x / p^2
+    uint64_t last_active_level(uint64_t low) const {
+        if (low == 0) return b_hard;
+        return min(b_hard, pi(max(sqrt_y, isqrt64(x / low))));
+    }
+    
+    // One block of consecutive hard-leaf segments. Leaves and phi counts
+    // are local to the block; the merge adds phi(block_low - 1, b - 1)
+    // times the block's sum of mu for each level.
+    struct HardBlock {
+        int64_t s2 = 0;
+        vector<int64_t> mu_sum;        // by b: sum of mu(m) over its leaves here
+        vector<uint64_t> level_count;  // by b: unsieved numbers at level b - 1
+    };
+    
+    struct HardBuffers {
+        vector<uint64_t> seg = vector<uint64_t>(SEGMENT_WORDS);
+        vector<uint32_t> counters = vector<uint32_t>(COUNTERS);
+        vector<uint64_t> next;  // next odd multiple of p_b
+    };
+    
+    void sieve_hard_block(uint64_t block_low, uint64_t block_high, HardBlock& out, HardBuffers& buf) const {
+        uint64_t b_top = last_active_level(block_low);
+        out.mu_sum.assign(b_top + 1, 0);
+        out.level_count.assign(b_top + 1, 0);
+        buf.next.resize(b_top + 1);
+        for (uint64_t b = C + 1; b <= b_top; b++) {
+            uint64_t p = primes[b - 1];
+            uint64_t m = (max(block_low, p) + p - 1) / p;
+            buf.next[b] = (m | 1) * p;
+        }
+        
+        uint64_t* seg = buf.seg.data();
+        uint32_t* counters = buf.counters.data();
+        
+        for (uint64_t low = block_low; low < block_high; low += SEGMENT_SPAN) {
+            uint64_t high = low + SEGMENT_SPAN;
+            
+            // Level C: the pattern already has 2..13 struck
+            uint64_t phase = (low / 128) % PRESIEVE_WORDS;
+            for (uint64_t filled = 0; filled < SEGMENT_WORDS; ) {
+                uint64_t chunk = min(SEGMENT_WORDS - filled, PRESIEVE_WORDS - phase);
+                memcpy(seg + filled, presieve_pattern.data() + phase, chunk * 8);
+                filled += chunk;
+                phase = 0;
+            }
+            
+            uint64_t seg_count = 0;
+            for (uint64_t c = 0; c < COUNTERS; c++) {
+                counters[c] = static_cast<uint32_t>(popcount_words(seg + c * COUNTER_WORDS, COUNTER_WORDS));
+                seg_count += counters[c];
+            }
+            
+            uint64_t b_seg = last_active_level(low);
+            for (uint64_t b = C + 1; b <= b_seg; b++) {
+                uint64_t p = primes[b - 1];
+                
+                // Leaves of b see the segment sieved by p_1 .. p_{b-1}
+                uint64_t m_hi = (low == 0) ? y : min(y, x / p / low);
+                uint64_t m_lo = x / p / high;
+                uint64_t ctr_pos = 0;
+                uint64_t ctr_sum = 0;
+                auto count_to = [&](uint64_t n) {
+                    if (n <= low) return uint64_t(0);
+                    uint64_t idx = (n - low - 1) >> 1;
+                    uint64_t ctr = idx >> COUNTER_SHIFT;
+                    while (ctr_pos < ctr) ctr_sum += counters[ctr_pos++];
+                    uint64_t total = ctr_sum;
+                    uint64_t w = ctr * COUNTER_WORDS;
+                    for (; w < (idx >> 6); w++) total += popcount64(seg[w]);
+                    uint64_t mask = ((idx & 63) == 63) ? ~0ULL : (2ULL << (idx & 63)) - 1;
+                    return total + popcount64(seg[w] & mask);
+                };
+                
+                int64_t leaf_sum = 0;
+                int64_t mu_sum = 0;
+                if (p <= sqrt_y) {
+                    m_lo = max(m_lo, y / p);
+                    for (uint64_t m = m_hi; m > m_lo; m--) {
+                        if (mu[m] && lpf[m] > p) {
+                            leaf_sum += mu[m] * static_cast<int64_t>(count_to(x / p / m));
+                            mu_sum += mu[m];
+                        }
+                    }
+                } else {
+                    m_lo = max(m_lo, p);
+                    m_hi = min(m_hi, x / p / p / p);
+                    if (m_hi > m_lo) {
+                        uint64_t l_lo = pi(m_lo);
+                        for (uint64_t l = pi(m_hi); l > l_lo; l--) {
+                            leaf_sum -= static_cast<int64_t>(count_to(x / p / primes[l - 1]));
+                            mu_sum--;
+                        }
+                    }
+                }
+                out.s2 -= leaf_sum + mu_sum * static_cast<int64_t>(out.level_count[b]);
+                out.mu_sum[b] += mu_sum;
+                out.level_count[b] += seg_count;
+                
+                // Strike p_b, keeping the counters exact
+                uint64_t v = buf.next[b];
+                for (; v < high; v += 2 * p) {
+                    uint64_t i = (v - low) >> 1;
+                    uint64_t bit = (seg[i >> 6] >> (i & 63)) & 1;
+                    seg[i >> 6] &= ~(1ULL << (i & 63));
+                    counters[i >> COUNTER_SHIFT] -= static_cast<uint32_t>(bit);
+                    seg_count -= bit;
+                }
+                buf.next[b] = v;
+            }
+        }
+    }
+    
+    // Hard leaves over [0, x / y], blocks handed out across all cores and
+    // merged in order
+    int64_t s2_hard() const {
+        if (b_hard <= C) return 0;
+        
+        uint64_t total_segments = (z + 1 + SEGMENT_SPAN - 1) / SEGMENT_SPAN;
+        uint64_t threads = g_cpu.logical_cores;
+        uint64_t block_segments = max<uint64_t>(1, total_segments / (threads * 16));
+        uint64_t num_blocks = (total_segments + block_segments - 1) / block_segments;
+        
+        vector<HardBlock> blocks(num_blocks);
+        atomic<uint64_t> next_block{0};
+        auto worker = [&]() {
+            HardBuffers buf;
+            for (uint64_t k; (k = next_block.fetch_add(1)) < num_blocks; ) {
+                uint64_t block_low = k * block_segments * SEGMENT_SPAN;
+                uint64_t block_high = min(total_segments, (k + 1) * block_segments) * SEGMENT_SPAN;
+                sieve_hard_block(block_low, block_high, blocks[k], buf);
+            }
+        };
+        
+        vector<thread> pool;
+        for (uint64_t t = 0; t < min(threads, num_blocks); t++) pool.emplace_back(worker);
+        for (auto& t : pool) t.join();
+        
+        int64_t s2 = 0;
+        vector<int64_t> phi_before(b_hard + 1, 0);
+        for (const HardBlock& blk : blocks) {
+            s2 += blk.s2;
+            for (uint64_t b = C + 1; b < blk.mu_sum.size(); b++) {
+                s2 -= blk.mu_sum[b] * phi_before[b];
+                phi_before[b] += static_cast<int64_t>(blk.level_count[b]);
+            }
+        }
+        return s2;
+    }
+    
+    int64_t s2_easy() const {
+        uint64_t b_first = max(C, pi(sqrt_y)) + 1;
+        if (b_first > a) return 0;
+        
+        struct alignas(64) PaddedSum { int64_t value = 0; };
+        vector<PaddedSum> sums(g_cpu.logical_cores);
+        atomic<uint64_t> next_b{b_first};
+        auto worker = [&](int t) {
+            for (uint64_t b; (b = next_b.fetch_add(1)) <= a; ) {
+                sums[t].value += easy_leaves(b);
+            }
+        };
+        
+        vector<thread> pool;
+        for (int t = 0; t < g_cpu.logical_cores; t++) pool.emplace_back(worker, t);
+        for (auto& t : pool) t.join();
+        
+        int64_t s2 = 0;
+        for (const auto& s : sums) s2 += s.value;
+        return s2;
+    }
+    
+    // P2 = sum over primes y < p <= sqrt(x) of pi(x / p) - pi(p) + 1. The
+    // x / p lie in [sqrt(x), x / y]; each sieved segment records its prime
+    // count and its share of the sum, and the segments are stitched in order.
+    int64_t p2() const {
+        uint64_t first = a;  // index of p_{a+1}
+        uint64_t last = primes.size();
+        if (first >= last) return 0;
+        
+        uint64_t lo = isqrt64(x);
+        uint64_t hi = x / primes[first];
+        uint64_t span = ParallelSegmentedSieve::segment_size();
+        
+        struct P2Segment {
+            uint64_t primes = 0;
+            uint64_t leaf_sum = 0;  // pi(x / p) counted from the segment start
+            uint64_t leaves = 0;
+        };
+        vector<P2Segment> segments((hi - lo) / span + 1);
+        
+        ParallelSegmentedSieve sieve;
+        sieve.sieve_segments(lo, hi, [&](int, uint64_t low, const uint8_t* segment, uint64_t size) {
+            P2Segment& s = segments[(low - lo) / span];
+            
+            // Primes p with x / p in this segment, largest p (smallest x / p) first
+            uint64_t p_begin = max(first, pi(x / (low + size)));
+            uint64_t p_end = min(last, pi(x / low));
+            uint64_t counted = 0;
+            for (uint64_t k = p_end; k > p_begin; k--) {
+                uint64_t end = x / primes[k - 1] - low + 1;
+                s.primes += count_set_bytes(segment + counted, end - counted);
+                counted = end;
+                s.leaf_sum += s.primes;
+                s.leaves++;
+            }
+            s.primes += count_set_bytes(segment + counted, size - counted);
+        });
+        
+        uint64_t sum = 0;
+        uint64_t pi_before = pi(lo - 1);
+        for (const P2Segment& s : segments) {
+            sum += s.leaf_sum + s.leaves * pi_before;
+            pi_before += s.primes;
+        }
+        
+        // Sum of pi(p) - 1 over p_{a+1} .. p_last
+        sum -= (last - 1) * last / 2 - (a - 1) * a / 2;
+        return static_cast<int64_t>(sum);
+    }
+    
+public:
+    // Listing primes needs a sieve anyway
+    vector<uint64_t> sieve(uint64_t n) override {
+        ParallelSegmentedSieve list_sieve;
+        return list_sieve.sieve(n);
+    }
+    
+    uint64_t count(uint64_t n) override {
+        if (n > MAX_X) return 0;
+        if (n < MIN_X) {
+            BitPackedUnrolledSieve bp;
+            return bp.count(n);
+        }
+        
+        // Larger alpha moves work from the x / y sieves to the leaves
+        x = n;
+        double alpha = max(1.0, pow(log(static_cast<double>(x)), 2) / 150);
+        y = min(static_cast<uint64_t>(alpha * icbrt64(x)), isqrt64(x) / 2);
+        z = x / y;
+        sqrt_y = isqrt64(y);
+        
+        init_tables();
+        a = pi(y);
+        b_hard = pi(min(y, isqrt64(isqrt64(x))));
+        
+        int64_t phi = s1() + s2_hard() + s2_easy();
+        return static_cast<uint64_t>(phi + static_cast<int64_t>(a) - 1 - p2());
+    }
+    
+    const char* name() const override { return "LMO Prime Counting"; }
+};
+
+// ============================================================================
+// Persistent Bitmap Cache
+// ============================================================================
+// The wheel-30 bitmap of [0, 30 * bytes) kept in a file and memory-mapped,
+// so later runs answer queries below the cached bound without sieving:
+//     header | primes >= 7 before each block (uint64_t) | bitmap
+// pi(n) is one index lookup plus a popcount of under one block. A query
+// past the bound sieves only the new bytes into a larger copy of the file
+// and renames it over the old one, so another process still mapping the
+// old file keeps a consistent view.
+
+class MappedSieveCache : public ISieve {
+private:
+    static constexpr uint64_t BLOCK_BYTES = 4096;  // 122880 integers per index entry
+    static constexpr uint64_t BLOCK_WORDS = BLOCK_BYTES / 8;
+    static constexpr uint64_t READ_BYTES = 262144;
+    static constexpr uint32_t VERSION = 1;
+    static_assert(BitPackedUnrolledSieve::segment_bytes() % BLOCK_BYTES == 0,
+                  "fill segments must end on block boundaries");
+    
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t block_bytes;
+        uint64_t bytes;          // bitmap length, a multiple of block_bytes
+        uint64_t index_offset;   // bytes / block_bytes + 1 running counts
+        uint64_t bitmap_offset;  // 64-byte aligned
+        uint64_t reserved[3];
+    };
+    static_assert(sizeof(Header) == 64, "header is one cache line");
+    
+    string path;
+    const uint8_t* base = nullptr;
+    uint64_t mapped_size = 0;
+    const uint64_t* index = nullptr;
+    const uint8_t* bitmap = nullptr;
+    uint64_t bytes = 0;
+    
+    BitPackedUnrolledSieve engine;  // fills the file, and answers if it can't be written
+    vector<uint64_t> buffer;
+    vector<uint64_t> stream_buffer;
+    
+    static constexpr uint64_t bitmap_offset_for(uint64_t blocks) {
+        return (sizeof(Header) + (blocks + 1) * 8 + 63) / 64 * 64;
+    }
+    
+    static void set_magic(char* magic) { memcpy(magic, "W30SIEVE", 8); }
+    
+    void unmap() {
+        if (base) {
+#ifdef _WIN32
+            UnmapViewOfFile(base);
+#else
+            munmap(const_cast<uint8_t*>(base), mapped_size);
+#endif
+        }
+        base = nullptr;
+        mapped_size = 0;
+        index = nullptr;
+        bitmap = nullptr;
+        bytes = 0;
+    }
+    
+    // Map path read-only; a missing, truncated or foreign file leaves the
+    // cache empty, to be replaced by the next extend()
+    void map_file() {
+        unmap();
+        
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return;
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(file, &size) && size.QuadPart >= static_cast<LONGLONG>(sizeof(Header))) {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping) {
+                base = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(mapping);
+            }
+            if (base) mapped_size = static_cast<uint64_t>(size.QuadPart);
+        }
+        CloseHandle(file);
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(Header))) {
+            void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (view != MAP_FAILED) {
+                base = static_cast<const uint8_t*>(view);
+                mapped_size = static_cast<uint64_t>(st.st_size);
+            }
+        }
+        close(fd);
+#endif
+        if (!base) return;
+        
+        Header h;
+        memcpy(&h, base, sizeof(h));
+        char magic[8];
+        set_magic(magic);
+        bool valid = memcmp(h.magic, magic, 8) == 0 && h.version == VERSION &&
+                     h.block_bytes == BLOCK_BYTES && h.bytes % BLOCK_BYTES == 0 &&
+                     h.bytes > 0 && h.bytes < mapped_size && h.index_offset == sizeof(Header) &&
+                     h.bitmap_offset == bitmap_offset_for(h.bytes / BLOCK_BYTES) &&
+                     h.bitmap_offset + h.bytes == mapped_size;
+        if (!valid) {
+            unmap();
+            return;
+        }
+        
+        index = reinterpret_cast<const uint64_t*>(base + h.index_offset);
+        bitmap = base + h.bitmap_offset;
+        bytes = h.bytes;
+    }
+    
+    // Write a cache of new_bytes next to path: the mapped bitmap is copied,
+    // only the rest is sieved, and the index is written once the counts are
+    // known. The finished file then replaces path.
+    bool extend(uint64_t new_bytes) {
+        string temp = path + ".tmp" + to_string(steady_clock::now().time_since_epoch().count());
+        FILE* out = fopen(temp.c_str(), "wb");
+        if (!out) return false;
+        
+        uint64_t blocks = new_bytes / BLOCK_BYTES;
+        Header h = {};
+        set_magic(h.magic);
+        h.version = VERSION;
+        h.block_bytes = BLOCK_BYTES;
+        h.bytes = new_bytes;
+        h.index_offset = sizeof(Header);
+        h.bitmap_offset = bitmap_offset_for(blocks);
+        
+        vector<uint64_t> counts(blocks + 1, 0);
+        uint64_t old_blocks = bytes / BLOCK_BYTES;
+        if (bytes) copy(index, index + old_blocks + 1, counts.begin());
+        
+        // Header and index are placeholders until the bitmap is down
+        vector<uint8_t> front(h.bitmap_offset, 0);
+        bool ok = fwrite(front.data(), 1, front.size(), out) == front.size();
+        if (ok && bytes) ok = fwrite(bitmap, 1, bytes, out) == bytes;
+        
+        if (ok) {
+            engine.sieve_segments(30 * bytes, 30 * new_bytes - 1, [&](const uint64_t* words, uint64_t count, uint64_t seg_start) {
+                if (!ok) return;
+                uint64_t block = seg_start / BLOCK_BYTES;
+                for (uint64_t w = 0; w < count; w += BLOCK_WORDS, block++) {
+                    counts[block + 1] = counts[block] + popcount_words(words + w, min(BLOCK_WORDS, count - w));
+                }
+                ok = fwrite(words, 8, count, out) == count;
+            });
+        }
+        
+        ok = ok && fseek(out, static_cast<long>(h.index_offset), SEEK_SET) == 0 &&
+             fwrite(counts.data(), 8, counts.size(), out) == counts.size() &&
+             fseek(out, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, out) == 1;
+        ok = (fclose(out) == 0) && ok;
+        
+        // Windows will not replace a file that is still mapped
+        unmap();
+#ifdef _WIN32
+        ok = ok && MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        ok = ok && rename(temp.c_str(), path.c_str()) == 0;
+#endif
+        if (!ok) remove(temp.c_str());
+        
+        map_file();
+        return ok && bytes >= new_bytes;
+    }
+    
+    // Hands the cached bitmap of [lo, hi] to on_segment(words, word_count,
+    // byte_start) in READ_BYTES pieces, like the engines' sieve_segments.
+    // The pieces are copies, trimmed to [lo, hi].
+    template <typename SegmentFn>
+    void read_segments(uint64_t lo, uint64_t hi, SegmentFn&& on_segment) {
+        uint64_t first_byte = lo / 30;
+        uint64_t total_bytes = hi / 30 + 1;
+        buffer.resize(READ_BYTES / 8);
+        uint8_t* seg = reinterpret_cast<uint8_t*>(buffer.data());
+        
+        for (uint64_t seg_start = first_byte; seg_start < total_bytes; seg_start += READ_BYTES) {
+            uint64_t seg_bytes = min(READ_BYTES, total_bytes - seg_start);
+            uint64_t words = (seg_bytes + 7) / 8;
+            
+            buffer[words - 1] = 0;
+            memcpy(seg, bitmap + seg_start, seg_bytes);
+            if (seg_start == first_byte) {
+                wheel30_clear_below(seg, seg_start, lo);
+            }
+            if (seg_start + seg_bytes == total_bytes) {
+                wheel30_clear_above(seg, seg_start, seg_bytes, hi);
+            }
+            
+            on_segment(buffer.data(), words, seg_start);
+        }
+    }
+    
+public:
+    explicit MappedSieveCache(string cache_path) : path(move(cache_path)) {
+        map_file();
+    }
+    
+    ~MappedSieveCache() override { unmap(); }
+    
+    MappedSieveCache(const MappedSieveCache&) = delete;
+    MappedSieveCache& operator=(const MappedSieveCache&) = delete;
+    
+    // Largest n answered straight from the file, 0 while it is empty
+    uint64_t bound() const { return bytes ? 30 * bytes - 1 : 0; }
+    
+    // Makes sure the file covers n, growing it by at least an eighth so a
+    // slowly rising bound does not copy the whole file every time. False
+    // if it cannot be written; queries then sieve as usual.
+    bool reserve(uint64_t n) {
+        if (n / 30 < bytes) return true;
+        if (n > UINT64_MAX - 30 * BLOCK_BYTES) return false;
+        
+        uint64_t need = max(n / 30 + 1, bytes + bytes / 8);
+        return extend((need + BLOCK_BYTES - 1) / BLOCK_BYTES * BLOCK_BYTES);
+    }
+    
+    bool is_prime(uint64_t n) {
+        if (n < 7) return n == 2 || n == 3 || n == 5;
+        if (!reserve(n)) {
+            bool found = false;
+            engine.for_each_prime(n, n, [&](const uint64_t*, size_t) { found = true; });
+            return found;
+        }
+        
+        int bit = g_wheel30.bit_of[n % 30];
+        return bit >= 0 && (bitmap[n / 30] >> bit & 1);
+    }
+    
+    uint64_t count(uint64_t n) override {
+        if (n < 2) return 0;
+        if (!reserve(n)) return engine.count(n);
+        
+        uint64_t last = n / 30;
+        uint64_t block_start = last / BLOCK_BYTES * BLOCK_BYTES;
+        uint64_t full_words = last % BLOCK_BYTES / 8;
+        
+        uint64_t total = (n >= 2) + (n >= 3) + (n >= 5) + index[last / BLOCK_BYTES];
+        total += popcount_words(reinterpret_cast<const uint64_t*>(bitmap + block_start), full_words);
+        for (uint64_t k = block_start + full_words * 8; k < last; k++) {
+            total += popcount64(bitmap[k]);
+        }
+        
+        uint8_t tail = 0;
+        for (int i = 0; i < 8; i++) {
+            if (g_wheel30.residue[i] <= n % 30) tail |= static_cast<uint8_t>(1u << i);
+        }
+        return total + popcount64(bitmap[last] & tail);
+    }
+    
+    vector<uint64_t> sieve(uint64_t n) override {
+        return sieve_range(0, n);
+    }
+    
+    // Sized exactly from the index, so the list is never reallocated
+    vector<uint64_t> sieve_range(uint64_t lo, uint64_t hi) override {
+        if (lo > hi || hi < 2) return {};
+        vector<uint64_t> primes;
+        if (!reserve(hi)) {
+            engine.for_each_prime(lo, hi, [&](const uint64_t* batch, size_t count) {
+                primes.insert(primes.end(), batch, batch + count);
+            });
+            return primes;
+        }
+        
+        primes.reserve(count(hi) - (lo ? count(lo - 1) : 0) + EXTRACT_SLACK);
+        for (uint64_t p : {2, 3, 5}) {
+            if (p >= lo && p <= hi) primes.push_back(p);
+        }
+        read_segments(lo, hi, [&](const uint64_t* words, uint64_t count, uint64_t seg_start) {
+            wheel30_append_primes(primes, words, count, seg_start);
+        });
+        return primes;
+    }
+    
+    void for_each_prime(uint64_t lo, uint64_t hi, const PrimeSink& sink) override {
+        if (lo > hi || hi < 2) return;
+        if (!reserve(hi)) {
+            engine.for_each_prime(lo, hi, sink);
+            return;
+        }
+        
+        for (uint64_t p : {2, 3, 5}) {
+            if (p >= lo && p <= hi) sink(&p, 1);
+        }
+        read_segments(lo, hi, [&](const uint64_t* words, uint64_t count, uint64_t seg_start) {
+            wheel30_stream_primes(words, count, seg_start, stream_buffer, sink);
+        });
+    }
+    
+    const char* name() const override { return "Mapped Bitmap Cache"; }
+};
+
+// ============================================================================
+// Auto-Selecting Optimal Sieve
+// ============================================================================
+
+class AutoOptimalSieve : public ISieve {
+private:
+    unique_ptr<ISieve> select_best_sieve(uint64_t n) {
+        // For cryptographic scale (>100M), always use parallel
+        if (n > 100000000) {
+            return make_unique<ParallelSegmentedSieve>();
+        }
+        
+        // For large scale (10M-100M)
+        if (n > 10000000) {
+            if (g_cpu.logical_cores >= 8) {
+                return make_unique<ParallelSegmentedSieve>();
+            } else if (g_cpu.avx512f) {
+                return make_unique<AVX512OptimizedSieve>();
+            } else if (g_cpu.avx2) {
+                return make_unique<AVX2OptimizedSieve>();
+            } else {
+                return make_unique<BitPackedUnrolledSieve>();
+            }
+        }
+        
+        // For medium scale (1M-10M)
+        if (n > 1000000) {
+            if (g_cpu.avx512f) {
+                return make_unique<AVX512OptimizedSieve>();
+            } else if (g_cpu.avx2) {
+                return make_unique<AVX2OptimizedSieve>();
+            } else {
+                return make_unique<BitPackedUnrolledSieve>();
+            }
+        }
+        
+        // For small scale (<1M)
+        return make_unique<BitPackedUnrolledSieve>();
+    }
+    
+public:
+    vector<uint64_t> sieve(uint64_t n) override {
+        auto best_sieve = select_best_sieve(n);
+        cout << "Auto-selected: " << best_sieve->name() << " for n=" << n << endl;
+        return best_sieve->sieve(n);
+    }
+    
+    vector<uint64_t> sieve_range(uint64_t lo, uint64_t hi) override {
+        // Windows starting near 2 are just a prefix sieve
+        if (lo <= 2) return sieve(hi);
+        
+        ParallelSegmentedSieve window_sieve;
+        cout << "Auto-selected: " << window_sieve.name() << " for [" << lo << ", " << hi << "]" << endl;
+        return window_sieve.sieve_range(lo, hi);
+    }
+    
+    uint64_t count(uint64_t n) override {
+        // Past 1e8 combinatorial counting beats any sieve
+        unique_ptr<ISieve> best_sieve;
+        if (n >= 100000000) {
+            best_sieve = make_unique<LMOPrimeCounter>();
+        } else {
+            best_sieve = select_best_sieve(n);
+        }
+        cout << "Auto-selected: " << best_sieve->name() << " for pi(" << n << ")" << endl;
+        return best_sieve->count(n);
+    }
+    
+    void for_each_prime(uint64_t lo, uint64_t hi, const PrimeSink& sink) override {
+        if (lo <= 2) {
+            auto best_sieve = select_best_sieve(hi);
+            cout << "Auto-selected: " << best_sieve->name() << " for [" << lo << ", " << hi << "]" << endl;
+            best_sieve->for_each_prime(lo, hi, sink);
+            return;
+        }
+        
+        ParallelSegmentedSieve window_sieve;
+        cout << "Auto-selected: " << window_sieve.name() << " for [" << lo << ", " << hi << "]" << endl;
+        window_sieve.for_each_prime(lo, hi, sink);
+    }
+    
+    const char* name() const override { return "Auto-Optimal"; }
+};
+
+// ============================================================================
+// Nth Prime
+// ============================================================================
+
+// li(x) = gamma + ln ln x + sum (ln x)^n / (n n!); every term is positive,
+// so long double holds it to full precision. Only used for nth_prime's guess.
+inline long double logarithmic_integral(long double x) {
+    const long double gamma = 0.5772156649015328606L;
+    long double ln_x = log(x);
+    long double sum = 0;
+    long double power = 1;  // (ln x)^n / n!
+    for (int n = 1; n < 1000; n++) {
+        power *= ln_x / n;
+        long double term = power / n;
+        sum += term;
+        if (term < 1e-20L * sum) break;
+    }
+    return gamma + log(ln_x) + sum;
+}
+
+// p_k, with p_1 = 2; 0 past the LMO count's exact range, k > pi(1e17).
+// The guess is li^-1(k), which lands within about sqrt(p_k) of the
+// answer, clamped to Dusart's bounds k(ln k + ln ln k - 1) <= p_k <=
+// k(ln k + ln ln k) and to LMOPrimeCounter::MAX_X. pi(guess) comes from
+// the LMO count, then only the primes between the guess and p_k are sieved.
+inline uint64_t nth_prime(uint64_t k) {
+    static const uint64_t first_primes[] = {2, 3, 5, 7, 11};
+    if (k == 0 || k > 2623557157654233ULL) return 0;  // pi(1e17)
+    if (k <= 5) return first_primes[k - 1];
+    
+    long double kk = static_cast<long double>(k);
+    long double lower = kk * (log(kk) + log(log(kk)) - 1);
+    long double upper = kk * (log(kk) + log(log(kk)));
+    
+    // Newton on li(x) = k
+    long double x = lower;
+    for (int i = 0; i < 20; i++) {
+        long double step = (logarithmic_integral(x) - kk) * log(x);
+        x -= step;
+        if (fabs(step) < 1) break;
+    }
+    x = min(max(x, lower), upper);
+    uint64_t guess = min(static_cast<uint64_t>(x), LMOPrimeCounter::MAX_X);
+    
+    LMOPrimeCounter counter;
+    uint64_t pi_guess = counter.count(guess);
+    
+    if (pi_guess < k) {
+        // Walk forward over the k - pi(guess) primes past the guess
+        uint64_t remaining = k - pi_guess;
+        for (uint64_t p : ParallelSegmentedSieve::primes_from(guess + 1)) {
+            if (--remaining == 0) return p;
+        }
+        return 0;
+    }
+    
+    // Overshot: p_k is the (pi(guess) - k + 1)-th prime at or below the guess
+    uint64_t back = pi_guess - k + 1;
+    ParallelSegmentedSieve window_sieve;
+    for (uint64_t width = static_cast<uint64_t>(back * log(x) * 2) + 1000; ; width *= 2) {
+        uint64_t lo = (guess > width) ? guess - width : 2;
+        vector<uint64_t> window = window_sieve.sieve_range(lo, guess);
+        if (window.size() >= back) return window[window.size() - back];
+    }
+}
+
+// ============================================================================
+// Primality Testing (Deterministic Miller-Rabin)
+// ============================================================================
+// For single 64-bit values past any sieve bound. Trial division by the
+// primes below 256 settles most composites and every n < 257^2; the rest
+// take Miller-Rabin with Sinclair's seven bases, which has no 64-bit
+// pseudoprimes. All modular products are Montgomery multiplications.
+
+// Divisibility by multiplication: for odd p, p | n iff n * p^-1 (mod 2^64)
+// <= (2^64 - 1) / p, so trial division needs no divide instruction; when
+// it does divide, n * p^-1 is the quotient
+struct TrialDivisionTable {
+    vector<uint32_t> primes;  // the odd primes <= limit
+    vector<uint64_t> inverse;
+    vector<uint64_t> max_quotient;
+    
+    explicit TrialDivisionTable(uint32_t limit) {
+        for (uint32_t p : sieving_primes_up_to(limit)) {
+            if (p == 2) continue;
+            uint64_t inv = p;
+            for (int i = 0; i < 5; i++) inv *= 2 - p * inv;  // Newton, bits double
+            primes.push_back(p);
+            inverse.push_back(inv);
+            max_quotient.push_back(~0ULL / p);
+        }
+    }
+};
+
+static const TrialDivisionTable g_trial_division(256);
+
+// Arithmetic modulo an odd n in Montgomery form, R = 2^64
+struct Montgomery64 {
+    uint64_t n = 1;
+    uint64_t inv = 1;        // n^-1 mod 2^64
+    uint64_t one = 0;        // R mod n
+    uint64_t minus_one = 0;  // -R mod n
+    uint64_t r2 = 0;         // R^2 mod n, for conversion
+    
+    Montgomery64() = default;
+    
+    explicit Montgomery64(uint64_t modulus) : n(modulus), inv(modulus) {
+        for (int i = 0; i < 5; i++) inv *= 2 - n * inv;
+        one = (0 - n) % n;
+        minus_one = n - one;
+        
+        // R^2 = R * 2^64: double R mod n 64 times, no 128-bit division
+        r2 = one;
+        for (int i = 0; i < 64; i++) r2 = (r2 >= n - r2) ? r2 - (n - r2) : r2 + r2;
+    }
+    
+    // (high:low) / R mod n for high < n. low - low(m * n) is exactly zero,
+    // so only the high halves are subtracted.
+    uint64_t reduce(uint64_t high, uint64_t low) const {
+        uint64_t mn_high = mul_high64(low * inv, n);
+        return (high >= mn_high) ? high - mn_high : high - mn_high + n;
+    }
+    
+    uint64_t mul(uint64_t a, uint64_t b) const {
+        uint64_t high;
+        uint64_t low = mul_wide64(a, b, high);
+        return reduce(high, low);
+    }
+    uint64_t to_mont(uint64_t a) const { return mul(a % n, r2); }
+};
+
+// Sinclair's bases: no strong pseudoprime to all seven below 2^64
+static constexpr uint64_t MR_BASES[] = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+
+// 0 composite, 1 prime, -1 not settled (odd, no factor below 256, n >= 257^2)
+inline int trial_division_u64(uint64_t n) {
+    if (n < 2) return 0;
+    if (!(n & 1)) return n == 2;
+    
+    const TrialDivisionTable& t = g_trial_division;
+    for (size_t i = 0; i < t.primes.size(); i++) {
+        if (n * t.inverse[i] <= t.max_quotient[i]) return n == t.primes[i];
+    }
+    return (n < 257 * 257) ? 1 : -1;
+}
+
+// Miller-Rabin on LANES odd candidates at once. Each lane's chain of
+// dependent multiplies is latency bound, so LANES independent chains fill
+// the multiplier. The exponentiation runs right to left with selects
+// instead of branches, for the longest exponent among the lanes.
+template <int LANES>
+inline void miller_rabin_lanes(const uint64_t* values, bool* prime) {
+    Montgomery64 mont[LANES];
+    uint64_t d[LANES];
+    int s[LANES];
+    bool alive[LANES];
+    
+    uint64_t all_bits = 0;
+    for (int l = 0; l < LANES; l++) {
+        mont[l] = Montgomery64(values[l]);
+        s[l] = ctz64(values[l] - 1);
+        d[l] = (values[l] - 1) >> s[l];
+        alive[l] = true;
+        all_bits |= d[l];
+    }
+    int bits = 0;
+    while (all_bits >> bits) bits++;
+    
+    for (uint64_t a : MR_BASES) {
+        uint64_t x[LANES], power[LANES];
+        for (int l = 0; l < LANES; l++) {
+            power[l] = mont[l].to_mont(a);
+            x[l] = mont[l].one;
+        }
+        
+        for (int i = 0; i < bits; i++) {
+            for (int l = 0; l < LANES; l++) {
+                uint64_t product = mont[l].mul(x[l], power[l]);
+                x[l] = ((d[l] >> i) & 1) ? product : x[l];
+                power[l] = mont[l].mul(power[l], power[l]);
+            }
+        }
+        
+        bool any_alive = false;
+        for (int l = 0; l < LANES; l++) {
+            // a = 0 mod n says nothing about n
+            if (alive[l] && a % values[l] != 0 && x[l] != mont[l].one && x[l] != mont[l].minus_one) {
+                bool witness = true;
+                for (int r = 1; r < s[l] && witness; r++) {
+                    x[l] = mont[l].mul(x[l], x[l]);
+                    if (x[l] == mont[l].minus_one) witness = false;
+                }
+                if (witness) alive[l] = false;
+            }
+            any_alive |= alive[l];
+        }
+        if (!any_alive) break;
+    }
+    
+    for (int l = 0; l < LANES; l++) prime[l] = alive[l];
+}
+
+// Deterministic for every 64-bit n
+inline bool is_prime_u64(uint64_t n) {
+    int settled = trial_division_u64(n);
+    if (settled >= 0) return settled == 1;
+    
+    bool prime;
+    miller_rabin_lanes<1>(&n, &prime);
+    return prime;
+}
+
+// is_prime_u64 over a batch: candidates that survive trial division are
+// tested four at a time, about 1.7x the throughput of single calls on
+// large primes
+inline void is_prime_u64_batch(const uint64_t* values, size_t count, bool* out) {
+    static constexpr int LANES = 4;
+    vector<uint64_t> pending;
+    vector<size_t> slot;
+    
+    for (size_t i = 0; i < count; i++) {
+        int settled = trial_division_u64(values[i]);
+        out[i] = (settled == 1);
+        if (settled < 0) {
+            pending.push_back(values[i]);
+            slot.push_back(i);
+        }
+    }
+    
+    // Pad the last group with copies of a real candidate
+    size_t survivors = pending.size();
+    while (pending.size() % LANES) pending.push_back(pending[0]);
+    
+    bool prime[LANES];
+    for (size_t g = 0; g < survivors; g += LANES) {
+        miller_rabin_lanes<LANES>(pending.data() + g, prime);
+        for (int l = 0; l < LANES && g + l < survivors; l++) out[slot[g + l]] = prime[l];
+    }
+}
+
+// ============================================================================
+// Integer Factorization (SPF Table, Trial Division, Pollard-Brent)
+// ============================================================================
+// factor(n) for any 64-bit n, by tiers: up to SMALL_FACTOR_LIMIT one SPF
+// table lookup per factor; above it trial division by the sieving primes
+// below 2^12, then Pollard-Brent rho in Montgomery form on whatever is
+// left, split until Miller-Rabin calls every piece prime.
+
+static constexpr uint64_t SMALL_FACTOR_LIMIT = 1ULL << 22;  // 2.2 MB table
+static constexpr uint32_t FACTOR_TRIAL_LIMIT = 1u << 12;
+
+// Built on first use
+inline const SpfTableSieve& small_factor_table() {
+    static const SpfTableSieve table = [] {
+        SpfTableSieve t;
+        t.build(SMALL_FACTOR_LIMIT);
+        return t;
+    }();
+    return table;
+}
+
+static const TrialDivisionTable g_factor_trial(FACTOR_TRIAL_LIMIT);
+
+// Binary GCD, no divisions
+inline uint64_t gcd_u64(uint64_t a, uint64_t b) {
+    if (!a || !b) return a | b;
+    int shift = ctz64(a | b);
+    a >>= ctz64(a);
+    while (b) {
+        b >>= ctz64(b);
+        if (a > b) swap(a, b);
+        b -= a;
+    }
+    return a << shift;
+}
+
+// A nontrivial factor of an odd composite n, not necessarily prime.
+// Brent's cycle finding on x^2 + c with the differences multiplied
+// together BATCH at a time, so only one gcd per batch; a batch that
+// overshoots to n is replayed step by step. c moves on if a run fails.
+inline uint64_t pollard_brent(uint64_t n) {
+    static constexpr uint64_t BATCH = 128;
+    const Montgomery64 mont(n);
+    auto add_mod = [n](uint64_t a, uint64_t b) {
+        uint64_t sum = a + b;
+        return (sum < a || sum >= n) ? sum - n : sum;
+    };
+    auto distance = [](uint64_t a, uint64_t b) { return a > b ? a - b : b - a; };
+    
+    for (uint64_t c = 1; ; c++) {
+        uint64_t c_mont = mont.to_mont(c);
+        auto step = [&](uint64_t x) { return add_mod(mont.mul(x, x), c_mont); };
+        
+        uint64_t x = 0, y = mont.to_mont(2), ys = y, q = mont.one, g = 1;
+        for (uint64_t r = 1; g == 1; r *= 2) {
+            x = y;
+            for (uint64_t i = 0; i < r; i++) y = step(y);
+            for (uint64_t k = 0; k < r && g == 1; k += BATCH) {
+                ys = y;
+                for (uint64_t i = 0; i < min(BATCH, r - k); i++) {
+                    y = step(y);
+                    q = mont.mul(q, distance(x, y));
+                }
+                g = gcd_u64(q, n);
+            }
+        }
+        
+        if (g == n) {
+            do {
+                ys = step(ys);
+                g = gcd_u64(distance(x, ys), n);
+            } while (g == 1);
+        }
+        if (g != n) return g;
+    }
+}
+
+// Prime factors of an odd n with no factor below FACTOR_TRIAL_LIMIT, in
+// no particular order
+inline void factor_rho(uint64_t n, vector<uint64_t>& out) {
+    if (n == 1) return;
+    if (is_prime_u64(n)) {
+        out.push_back(n);
+        return;
+    }
+    uint64_t d = pollard_brent(n);
+    factor_rho(d, out);
+    factor_rho(n / d, out);
+}
+
+// Appends the prime factors of n, ascending with multiplicity; nothing
+// for 0 and 1
+inline void factor(uint64_t n, vector<uint64_t>& out) {
+    if (n < 2) return;
+    if (n <= SMALL_FACTOR_LIMIT) {
+        small_factor_table().factor(n, out);
+        return;
+    }
+    
+    int twos = ctz64(n);
+    for (int i = 0; i < twos; i++) out.push_back(2);
+    n >>= twos;
+    
+    const TrialDivisionTable& t = g_factor_trial;
+    for (size_t i = 0; i < t.primes.size() && n > 1; i++) {
+        uint64_t p = t.primes[i];
+        if (p * p > n) break;
+        while (n * t.inverse[i] <= t.max_quotient[i]) {
+            out.push_back(p);
+            n *= t.inverse[i];
+        }
+    }
+    if (n == 1) return;
+    
+    // No factor below the trial bound: below its square n is prime
+    if (n < static_cast<uint64_t>(FACTOR_TRIAL_LIMIT) * FACTOR_TRIAL_LIMIT) {
+        out.push_back(n);
+        return;
+    }
+    size_t first_large = out.size();
+    factor_rho(n, out);
+    sort(out.begin() + first_large, out.end());
+}
+
+inline vector<uint64_t> factor(uint64_t n) {
+    vector<uint64_t> factors;
+    factor(n, factors);
+    return factors;
+}
+
+// factor() over a batch on all cores: out[i] receives the factors of
+// values[i]. Blocks of values are handed out as they are claimed, since
+// one hard semiprime can cost as much as thousands of easy numbers.
+inline void factor_batch(const uint64_t* values, size_t count, vector<uint64_t>* out) {
+    static constexpr size_t BLOCK = 64;
+    size_t num_blocks = (count + BLOCK - 1) / BLOCK;
+    small_factor_table();  // built up front, not inside the first worker
+    
+    atomic<size_t> next_block{0};
+    auto worker = [&]() {
+        for (size_t b; (b = next_block.fetch_add(1)) < num_blocks; ) {
+            for (size_t i = b * BLOCK; i < min(count, (b + 1) * BLOCK); i++) {
+                out[i].clear();
+                factor(values[i], out[i]);
+            }
+        }
+    };
+    
+    vector<thread> pool;
+    size_t threads = min<size_t>(g_cpu.logical_cores, num_blocks);
+    for (size_t t = 0; t < threads; t++) pool.emplace_back(worker);
+    for (auto& t : pool) t.join();
+}
+
+// ============================================================================
 // Benchmarking
 // ============================================================================
 
-void benchmark(ISieve* sieve, int n, int runs = 3) {
+void benchmark(ISieve* sieve, uint64_t n, int runs = 3) {
     // Warm up
-    sieve->sieve(min(n/100, 10000));
+    sieve->sieve(min<uint64_t>(n/100, 10000));
     
     double total_time = 0;
-    vector<int> result;
+    vector<uint64_t> result;
     
     for (int i = 0; i < runs; i++) {
         auto start = high_resolution_clock::now();
@@ -532,6 +3828,23 @@ void benchmark(ISieve* sieve, int n, int runs = 3) {
     cout << sieve->name() << ": " 
          << (total_time / runs) << " ms (avg of " << runs << " runs), "
          << "found " << result.size() << " primes" << endl;
+    
+    // Count-only mode: same sieve, popcounted, no prime list
+    double count_time = 0;
+    uint64_t count = 0;
+    
+    for (int i = 0; i < runs; i++) {
+        auto start = high_resolution_clock::now();
+        count = sieve->count(n);
+        auto end = high_resolution_clock::now();
+        
+        auto duration = duration_cast<microseconds>(end - start);
+        count_time += duration.count() / 1000.0;
+    }
+    
+    cout << sieve->name() << " [count]: " 
+         << (count_time / runs) << " ms (avg of " << runs << " runs), "
+         << "pi(n) = " << count << endl;
 }
 
 // ============================================================================
@@ -546,9 +3859,9 @@ int main() {
     g_cpu.print();
     
     // Test scales
-    vector<int> test_sizes = {500000, 10000000, 50000000};
+    vector<uint64_t> test_sizes = {500000, 10000000, 50000000};
     
-    for (int n : test_sizes) {
+    for (uint64_t n : test_sizes) {
         cout << "\n" << string(50, '-') << endl;
         cout << "Benchmarking with n = " << n << endl;
         cout << string(50, '-') << endl;
@@ -561,6 +3874,10 @@ int main() {
             sieves.push_back(make_unique<AVX2OptimizedSieve>());
         }
         
+        if (g_cpu.avx512f) {
+            sieves.push_back(make_unique<AVX512OptimizedSieve>());
+        }
+        
         if (n >= 10000000 && g_cpu.logical_cores >= 4) {
             sieves.push_back(make_unique<ParallelSegmentedSieve>());
         }
@@ -577,8 +3894,8 @@ int main() {
     cout << "\n" << string(50, '-') << endl;
     cout << "Verification (first 20 primes):" << endl;
     BitPackedUnrolledSieve verify;
-    vector<int> primes = verify.sieve(100);
-    for (int i = 0; i < min(20, (int)primes.size()); i++) {
+    vector<uint64_t> primes = verify.sieve(100);
+    for (size_t i = 0; i < min<size_t>(20, primes.size()); i++) {
         cout << primes[i] << " ";
     }
     cout << endl;
@@ -599,5 +3916,272 @@ int main() {
     cout << "Rate: " << (100000000.0 / duration.count()) / 1000 
          << " million numbers/second" << endl;
     
+    // Interval sieving far from the origin
+    cout << "\n" << string(50, '-') << endl;
+    cout << "Interval Demo [1e12, 1e12 + 1e8]:" << endl;
+    cout << string(50, '-') << endl;
+    
+    uint64_t lo = 1000000000000ULL;
+    uint64_t hi = lo + 100000000ULL;
+    start = high_resolution_clock::now();
+    auto window = crypto_sieve.sieve_range(lo, hi);
+    end = high_resolution_clock::now();
+    
+    duration = duration_cast<milliseconds>(end - start);
+    cout << "Found " << window.size() << " primes in " 
+         << duration.count() << " ms";
+    if (!window.empty()) {
+        cout << " (first " << window.front() << ", last " << window.back() << ")";
+    }
+    cout << endl;
+    
+    // Lazy generation: sieve only as far as the loop reads
+    cout << "\n" << string(50, '-') << endl;
+    cout << "Lazy Generator Demo (first twin primes above 1e15):" << endl;
+    cout << string(50, '-') << endl;
+    
+    start = high_resolution_clock::now();
+    uint64_t previous = 0;
+    for (uint64_t p : ParallelSegmentedSieve::primes_from(1000000000000000ULL)) {
+        if (p - previous == 2) break;
+        previous = p;
+    }
+    end = high_resolution_clock::now();
+    
+    duration = duration_cast<milliseconds>(end - start);
+    cout << "(" << previous << ", " << previous + 2 << ") in " << duration.count() << " ms" << endl;
+    
+    // Sublinear prime counting
+    cout << "\n" << string(50, '-') << endl;
+    cout << "Prime Counting Demo (LMO):" << endl;
+    cout << string(50, '-') << endl;
+    
+    LMOPrimeCounter counter;
+    for (uint64_t x : {10000000000ULL, 1000000000000ULL, 100000000000000ULL}) {
+        start = high_resolution_clock::now();
+        uint64_t pi_x = counter.count(x);
+        end = high_resolution_clock::now();
+        
+        duration = duration_cast<milliseconds>(end - start);
+        cout << "pi(" << x << ") = " << pi_x << " in " << duration.count() << " ms" << endl;
+    }
+    
+    for (uint64_t k : {1000000000ULL, 1000000000000ULL}) {
+        start = high_resolution_clock::now();
+        uint64_t p_k = nth_prime(k);
+        end = high_resolution_clock::now();
+        
+        duration = duration_cast<milliseconds>(end - start);
+        cout << "p(" << k << ") = " << p_k << " in " << duration.count() << " ms" << endl;
+    }
+    
+    // Persistent cache: the first run sieves and writes the file, later
+    // runs map it and answer without sieving
+    cout << "\n" << string(50, '-') << endl;
+    cout << "Bitmap Cache Demo (the-beast.w30cache):" << endl;
+    cout << string(50, '-') << endl;
+    
+    MappedSieveCache cache("the-beast.w30cache");
+    bool was_cached = cache.bound() >= 1000000000ULL;
+    start = high_resolution_clock::now();
+    uint64_t pi_cached = cache.count(1000000000ULL);
+    end = high_resolution_clock::now();
+    
+    auto cache_time = duration_cast<microseconds>(end - start);
+    cout << "pi(1000000000) = " << pi_cached << " in " << cache_time.count() / 1000.0 << " ms ("
+         << (was_cached ? "mapped" : "sieved and cached") << ", bound " << cache.bound() << ")" << endl;
+    
+    // Compressed list: about one byte per prime instead of eight
+    cout << "\n" << string(50, '-') << endl;
+    cout << "Compressed PrimeList Demo (n = 1,000,000,000):" << endl;
+    cout << string(50, '-') << endl;
+    
+    BitPackedUnrolledSieve list_sieve;
+    start = high_resolution_clock::now();
+    PrimeList list = list_sieve.sieve_list(0, 1000000000ULL);
+    end = high_resolution_clock::now();
+    duration = duration_cast<milliseconds>(end - start);
+    
+    uint64_t prime_sum = 0;
+    start = high_resolution_clock::now();
+    list.for_each_batch([&](const uint64_t* batch, size_t count) {
+        for (size_t i = 0; i < count; i++) prime_sum += batch[i];
+    });
+    end = high_resolution_clock::now();
+    
+    cout << list.size() << " primes in " << list.memory_bytes() / 1048576 << " MB ("
+         << list.size() * sizeof(uint64_t) / 1048576 << " MB as vector<uint64_t>), built in "
+         << duration.count() << " ms" << endl;
+    cout << "Sum " << prime_sum << " decoded in "
+         << duration_cast<milliseconds>(end - start).count() << " ms" << endl;
+    
+    // Membership queries straight against the bitmap
+    cout << "\n" << string(50, '-') << endl;
+    cout << "Bitmap Membership Demo (10,000,000 random queries below 1e9):" << endl;
+    cout << string(50, '-') << endl;
+    
+    PrimeBitmap prime_bits = list_sieve.bitmap(1000000000ULL);
+    vector<uint64_t> queries(10000000);
+    uint64_t state = 88172645463325252ULL;
+    for (uint64_t& q : queries) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        q = state % 1000000000ULL;
+    }
+    unique_ptr<bool[]> hits(new bool[queries.size()]);
+    
+    start = high_resolution_clock::now();
+    prime_bits.contains(queries.data(), queries.size(), hits.get());
+    end = high_resolution_clock::now();
+    
+    cout << count(hits.get(), hits.get() + queries.size(), true) << " primes in "
+         << duration_cast<milliseconds>(end - start).count() << " ms ("
+         << prime_bits.word_count() * 8 / 1048576 << " MB bitmap)" << endl;
+    
+    // The same queries as pi(x) and as k-th prime lookups
+    uint64_t checksum = 0;
+    start = high_resolution_clock::now();
+    for (uint64_t q : queries) checksum += prime_bits.rank(q);
+    end = high_resolution_clock::now();
+    auto rank_time = duration_cast<milliseconds>(end - start);
+    
+    start = high_resolution_clock::now();
+    for (uint64_t q : queries) checksum += prime_bits.select(q % prime_bits.count() + 1);
+    end = high_resolution_clock::now();
+    
+    cout << "rank in " << rank_time.count() << " ms, select in "
+         << duration_cast<milliseconds>(end - start).count() << " ms (index "
+         << 100.0 * prime_bits.index_bytes() / (prime_bits.word_count() * 8) << "% of the bitmap, checksum "
+         << checksum << ")" << endl;
+    
+    // Several statistics from one parallel pass, no prime list
+    cout << "\n" << string(50, '-') << endl;
+    cout << "Reducer Demo [2, 1e9] (count, sum, sum of squares, max and record gaps):" << endl;
+    cout << string(50, '-') << endl;
+    
+    ParallelSegmentedSieve reducer_sieve;
+    start = high_resolution_clock::now();
+    auto [prime_count, sum, square_sum, gap, records] = reducer_sieve.reduce(2, 1000000000ULL,
+        PrimeCountReducer(), PrimeSumReducer(), PrimeSquareSumReducer(), MaxGapReducer(), RecordGapReducer());
+    end = high_resolution_clock::now();
+    
+    cout << "pi = " << prime_count.count << ", sum = " << sum.sum.to_string()
+         << ", sum of squares = " << square_sum.sum.to_string() << endl;
+    cout << "max gap " << gap.gap << " after " << gap.gap_low << ", in "
+         << duration_cast<milliseconds>(end - start).count() << " ms" << endl;
+    cout << records.records.size() << " record gaps:";
+    for (const auto& r : records.records) cout << " " << r.gap << "@" << r.low;
+    cout << endl;
+    
+    // Primality of single values past every sieve bound
+    cout << "\n" << string(50, '-') << endl;
+    cout << "Miller-Rabin Demo (1,000,000 odd numbers above 2^63):" << endl;
+    cout << string(50, '-') << endl;
+    
+    vector<uint64_t> candidates(1000000);
+    for (size_t i = 0; i < candidates.size(); i++) candidates[i] = (1ULL << 63) + 2 * i + 1;
+    unique_ptr<bool[]> is_prime_flags(new bool[candidates.size()]);
+    
+    start = high_resolution_clock::now();
+    is_prime_u64_batch(candidates.data(), candidates.size(), is_prime_flags.get());
+    end = high_resolution_clock::now();
+    
+    size_t found = count(is_prime_flags.get(), is_prime_flags.get() + candidates.size(), true);
+    cout << found << " primes in " << duration_cast<milliseconds>(end - start).count() << " ms; "
+         << "2^64 - 59 is " << (is_prime_u64(18446744073709551557ULL) ? "prime" : "composite") << endl;
+    
+    // Constellations from shifted segment flags, no prime list
+    cout << "\n" << string(50, '-') << endl;
+    cout << "Prime Constellation Demo [2, 1e9]:" << endl;
+    cout << string(50, '-') << endl;
+    
+    vector<pair<const char*, vector<uint32_t>>> patterns = {
+        {"twin (p, p+2)", {0, 2}},
+        {"cousin (p, p+4)", {0, 4}},
+        {"sexy (p, p+6)", {0, 6}},
+        {"triplet (p, p+2, p+6)", {0, 2, 6}},
+        {"quadruplet (p, p+2, p+6, p+8)", {0, 2, 6, 8}},
+    };
+    ParallelSegmentedSieve tuple_sieve;
+    for (const auto& [label, offsets] : patterns) {
+        start = high_resolution_clock::now();
+        uint64_t tuples = tuple_sieve.count_tuples(2, 1000000000ULL, offsets);
+        end = high_resolution_clock::now();
+    
+        cout << label << ": " << tuples << " in "
+             << duration_cast<milliseconds>(end - start).count() << " ms" << endl;
+    }
+    
+    // Factoring by table lookup
+    cout << "\n" << string(50, '-') << endl;
+    cout << "SPF Table Demo (factor 10,000,000 random numbers below 1e9):" << endl;
+    cout << string(50, '-') << endl;
+    
+    SpfTableSieve spf_table;
+    start = high_resolution_clock::now();
+    spf_table.build(1000000000ULL);
+    end = high_resolution_clock::now();
+    cout << "built in " << duration_cast<milliseconds>(end - start).count() << " ms ("
+         << spf_table.memory_bytes() / 1048576 << " MB)" << endl;
+    
+    vector<uint64_t> factors;
+    uint64_t factor_total = 0;
+    start = high_resolution_clock::now();
+    for (uint64_t q : queries) {
+        factors.clear();
+        spf_table.factor(q + 1, factors);
+        factor_total += factors.size();
+    }
+    end = high_resolution_clock::now();
+    cout << factor_total << " prime factors in " << duration_cast<milliseconds>(end - start).count() << " ms; 999999999 =";
+    for (uint64_t f : spf_table.factor(999999999)) cout << " " << f;
+    cout << endl;
+    
+    // Every integer of a window factored by the segmented sieve
+    cout << "\n" << string(50, '-') << endl;
+    cout << "Range Factorization Demo [1e12, 1e12 + 1e7]:" << endl;
+    cout << string(50, '-') << endl;
+    
+    ParallelSegmentedSieve factor_sieve;
+    uint64_t window_factors = 0;
+    vector<uint64_t> first_factors;
+    start = high_resolution_clock::now();
+    factor_sieve.factor_range(1000000000000ULL, 1000010000000ULL, [&](const FactorBlock& block) {
+        window_factors += block.factors.size();
+        if (first_factors.empty()) first_factors.assign(block.factors.begin() + block.start[1], block.factors.begin() + block.start[2]);
+    });
+    end = high_resolution_clock::now();
+    
+    cout << window_factors << " prime factors in " << duration_cast<milliseconds>(end - start).count()
+         << " ms; 1000000000001 =";
+    for (uint64_t f : first_factors) cout << " " << f;
+    cout << endl;
+    
+    // Single 64-bit values: table, trial division, then Pollard-Brent
+    cout << "\n" << string(50, '-') << endl;
+    cout << "factor() Demo (100,000 random 64-bit numbers, all cores):" << endl;
+    cout << string(50, '-') << endl;
+    
+    vector<uint64_t> to_factor(100000);
+    for (uint64_t& v : to_factor) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        v = state;
+    }
+    vector<vector<uint64_t>> factorizations(to_factor.size());
+    
+    start = high_resolution_clock::now();
+    factor_batch(to_factor.data(), to_factor.size(), factorizations.data());
+    end = high_resolution_clock::now();
+    cout << "factored in " << duration_cast<milliseconds>(end - start).count() << " ms" << endl;
+    
+    for (uint64_t n : {18446744073709551615ULL, 18446743979220271189ULL}) {
+        cout << n << " =";
+        for (uint64_t f : factor(n)) cout << " " << f;
+        cout << endl;
+    }
+    
     return 0;
 }
\ No newline at end of file
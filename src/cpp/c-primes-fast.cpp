@@ -3,13 +3,64 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <algorithm>
+#include <cstdint>
 #include <omp.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 // Helper macros for bit manipulation
 #define SET_BIT(arr, idx)   (arr[(idx) >> 6] |= (1ULL << ((idx) & 63)))
 #define CLEAR_BIT(arr, idx) (arr[(idx) >> 6] &= ~(1ULL << ((idx) & 63)))
 #define TEST_BIT(arr, idx)  (arr[(idx) >> 6] & (1ULL << ((idx) & 63)))
 
+// Table-driven bitmap-to-prime extraction (same kernel as the-beast's
+// wheel30_extract_avx2, for the odd-only layout). Each byte of the bitset
+// covers 8 odd numbers; the table gives the odd offsets 2j+1 of its set
+// bits packed to the front, so every byte is one full 8-lane store and the
+// output pointer advances by its popcount - no per-prime branch.
+struct OddExtractTable {
+    alignas(8) uint8_t offsets[256][8];
+
+    OddExtractTable() {
+        for (int m = 0; m < 256; m++) {
+            int found = 0;
+            for (int j = 0; j < 8; j++) {
+                if (m & (1 << j)) offsets[m][found++] = (uint8_t)(2 * j + 1);
+            }
+            while (found < 8) offsets[m][found++] = 0;
+        }
+    }
+};
+static const OddExtractTable odd_extract_table;
+
+// Writes the primes of bitset words [first, last) to [out, out_end). The
+// 8-wide stores run while a full store still fits, and the last few primes
+// are written exactly, so neighbouring blocks can be filled concurrently.
+static void extract_odd_primes(const unsigned long long* words, std::size_t first, std::size_t last,
+                               unsigned long long* out, unsigned long long* out_end) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(words);
+    std::size_t b = first * 8;
+    for (; b < last * 8 && out + 8 <= out_end; b++) {
+        uint8_t m = bytes[b];
+        unsigned long long base = 16ULL * b;
+#ifdef __AVX2__
+        __m256i vbase = _mm256_set1_epi64x((long long)base);
+        __m128i r = _mm_loadl_epi64((const __m128i*)odd_extract_table.offsets[m]);
+        _mm256_storeu_si256((__m256i*)out, _mm256_add_epi64(vbase, _mm256_cvtepu8_epi64(r)));
+        _mm256_storeu_si256((__m256i*)(out + 4), _mm256_add_epi64(vbase, _mm256_cvtepu8_epi64(_mm_srli_si128(r, 4))));
+#else
+        for (int j = 0; j < 8; j++) out[j] = base + odd_extract_table.offsets[m][j];
+#endif
+        out += __builtin_popcount(m);
+    }
+    for (; b < last * 8; b++) {
+        uint8_t m = bytes[b];
+        for (int j = 0; j < __builtin_popcount(m); j++) *out++ = 16ULL * b + odd_extract_table.offsets[m][j];
+    }
+}
+
 // This function returns a list of primes up to n.
 std::vector<unsigned long long> sieve_odd_bitset_parallel(unsigned long long n) {
     if (n < 2) {
@@ -61,20 +112,40 @@ std::vector<unsigned long long> sieve_odd_bitset_parallel(unsigned long long n)
         }
     }
 
-    // Collect primes from the bitset
-    std::vector<unsigned long long> primes;
-    primes.reserve(size / 10); // rough guess for capacity
-    primes.push_back(2ULL);    // add the even prime
-
-    for (unsigned long long i = 1; i < size; i++) {
-        if (TEST_BIT(bitset, i)) {
-            unsigned long long p = (i << 1) + 1ULL;
-            if (p <= n) {
-                primes.push_back(p);
-            } else {
-                break;
-            }
+    // Collect primes from the bitset. Clear every bit past the last odd
+    // number <= n first, so the extraction needs no bound check; blocks are
+    // counted in parallel, then each thread writes its block at its exact
+    // offset in the preallocated output.
+    unsigned long long valid = (n + 1) >> 1;  // indices 0 .. (n-1)/2
+    for (unsigned long long i = valid; i < bitset.size() * 64; i++) {
+        CLEAR_BIT(bitset, i);
+    }
+
+    const std::size_t BLOCK_WORDS = 4096;
+    std::size_t blocks = (bitset.size() + BLOCK_WORDS - 1) / BLOCK_WORDS;
+    std::vector<std::size_t> offsets(blocks + 1, 0);
+
+    #pragma omp parallel for schedule(static)
+    for (long long blk = 0; blk < (long long)blocks; blk++) {
+        std::size_t end = std::min(bitset.size(), (std::size_t)(blk + 1) * BLOCK_WORDS);
+        std::size_t count = 0;
+        for (std::size_t w = (std::size_t)blk * BLOCK_WORDS; w < end; w++) {
+            count += __builtin_popcountll(bitset[w]);
         }
+        offsets[blk + 1] = count;
+    }
+    for (std::size_t blk = 0; blk < blocks; blk++) {
+        offsets[blk + 1] += offsets[blk];
+    }
+
+    std::vector<unsigned long long> primes(1 + offsets[blocks]);
+    primes[0] = 2ULL;  // the even prime
+
+    #pragma omp parallel for schedule(static)
+    for (long long blk = 0; blk < (long long)blocks; blk++) {
+        std::size_t end = std::min(bitset.size(), (std::size_t)(blk + 1) * BLOCK_WORDS);
+        extract_odd_primes(bitset.data(), (std::size_t)blk * BLOCK_WORDS, end,
+                           primes.data() + 1 + offsets[blk], primes.data() + 1 + offsets[blk + 1]);
     }
     return primes;
 }